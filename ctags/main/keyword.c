@@ -24,52 +24,54 @@
 *   DATA DECLARATIONS
 */
 typedef struct sHashEntry {
-	struct sHashEntry *next;
-	const char *string;
-	langType language;
+	const char *string;  /* NULL for an empty slot */
+	unsigned int hash;
 	int value;
 } hashEntry;
 
+/*  Open addressed table of the keywords of one language. Parsers only add
+ *  keywords when they are initialized so the tables are read-only while
+ *  parsing and lookups need no locking.
+ */
+typedef struct sHashTable {
+	hashEntry *entries;
+	unsigned int size;  /* power of two, 0 before the first keyword */
+	unsigned int count;
+} hashTable;
+
 /*
 *   DATA DEFINITIONS
 */
-static const unsigned int TableSize = 2039;  /* prime */
-static hashEntry **HashTable = NULL;
+static const unsigned int MinTableSize = 16;
+static hashTable *HashTables = NULL;  /* indexed by language */
+static unsigned int HashTableCount = 0;
 
 /*
 *   FUNCTION DEFINITIONS
 */
 
-static hashEntry **getHashTable (void)
+static hashTable *getHashTable (langType language)
 {
-	static bool allocated = false;
+	Assert (language >= 0);
 
-	if (! allocated)
+	if ((unsigned int) language >= HashTableCount)
 	{
+		unsigned int count = language + 1;
 		unsigned int i;
 
-		HashTable = xMalloc (TableSize, hashEntry*);
-
-		for (i = 0  ;  i < TableSize  ;  ++i)
-			HashTable [i] = NULL;
-
-		allocated = true;
+		HashTables = xRealloc (HashTables, count, hashTable);
+		for (i = HashTableCount  ;  i < count  ;  ++i)
+		{
+			HashTables [i].entries = NULL;
+			HashTables [i].size = 0;
+			HashTables [i].count = 0;
+		}
+		HashTableCount = count;
 	}
-	return HashTable;
-}
-
-static hashEntry *getHashTableEntry (unsigned long hashedValue)
-{
-	hashEntry **const table = getHashTable ();
-	hashEntry *entry;
-
-	Assert (hashedValue < TableSize);
-	entry = table [hashedValue];
-
-	return entry;
+	return &HashTables [language];
 }
 
-static unsigned int hashValue (const char *const string, langType language)
+static unsigned int hashValue (const char *const string)
 {
 	const signed char *p;
 	unsigned int h = 5381;
@@ -80,23 +82,43 @@ static unsigned int hashValue (const char *const string, langType language)
 	for (p = (const signed char *)string; *p != '\0'; p++)
 		h = (h << 5) + h + *p;
 
-	/* consider language as an extra "character" and add it to the hash */
-	h = (h << 5) + h + language;
-
 	return h;
 }
 
-static hashEntry *newEntry (
-		const char *const string, langType language, int value)
+static hashEntry *findSlot (const hashTable *const table,
+		const char *const string, unsigned int hash)
 {
-	hashEntry *const entry = xMalloc (1, hashEntry);
+	const unsigned int mask = table->size - 1;
+	unsigned int index = hash & mask;
+
+	/* linear probing, the table is at most half full */
+	while (table->entries [index].string != NULL)
+	{
+		hashEntry *const entry = &table->entries [index];
 
-	entry->next     = NULL;
-	entry->string   = string;
-	entry->language = language;
-	entry->value    = value;
+		if (entry->hash == hash  &&  strcmp (string, entry->string) == 0)
+			return entry;
+		index = (index + 1) & mask;
+	}
+	return &table->entries [index];
+}
 
-	return entry;
+static void growTable (hashTable *const table)
+{
+	hashEntry *const old = table->entries;
+	const unsigned int oldSize = table->size;
+	unsigned int i;
+
+	table->size = (oldSize == 0) ? MinTableSize : 2 * oldSize;
+	table->entries = xCalloc (table->size, hashEntry);
+
+	for (i = 0  ;  i < oldSize  ;  ++i)
+	{
+		if (old [i].string != NULL)
+			*findSlot (table, old [i].string, old [i].hash) = old [i];
+	}
+	if (old != NULL)
+		eFree (old);
 }
 
 /*  Note that it is assumed that a "value" of zero means an undefined keyword
@@ -106,125 +128,92 @@ static hashEntry *newEntry (
  */
 extern void addKeyword (const char *const string, langType language, int value)
 {
-	const unsigned int index = hashValue (string, language) % TableSize;
-	hashEntry *entry = getHashTableEntry (index);
+	hashTable *const table = getHashTable (language);
+	const unsigned int hash = hashValue (string);
+	hashEntry *entry;
 
-	if (entry == NULL)
-	{
-		hashEntry **const table = getHashTable ();
-		table [index] = newEntry (string, language, value);
-	}
-	else
-	{
-		hashEntry *prev = NULL;
+	if (2 * (table->count + 1) > table->size)
+		growTable (table);
 
-		while (entry != NULL)
-		{
-			if (language == entry->language  &&
-				strcmp (string, entry->string) == 0)
-			{
-				Assert (("Already in table" == NULL));
-			}
-			prev = entry;
-			entry = entry->next;
-		}
-		if (entry == NULL)
-		{
-			Assert (prev != NULL);
-			prev->next = newEntry (string, language, value);
-		}
+	entry = findSlot (table, string, hash);
+	if (entry->string != NULL)
+	{
+		Assert (("Already in table" == NULL));
+		return;
 	}
+	entry->string = string;
+	entry->hash   = hash;
+	entry->value  = value;
+	table->count++;
 }
 
 extern int lookupKeyword (const char *const string, langType language)
 {
-	const unsigned int index = hashValue (string, language) % TableSize;
-	hashEntry *entry = getHashTableEntry (index);
-	int result = -1;
+	const hashTable *table;
+	const hashEntry *entry;
 
-	while (entry != NULL)
-	{
-		if (language == entry->language  &&  strcmp (string, entry->string) == 0)
-		{
-			result = entry->value;
-			break;
-		}
-		entry = entry->next;
-	}
-	return result;
+	if (language < 0  ||  (unsigned int) language >= HashTableCount)
+		return -1;
+
+	table = &HashTables [language];
+	if (table->count == 0)
+		return -1;
+
+	entry = findSlot (table, string, hashValue (string));
+	return (entry->string != NULL) ? entry->value : -1;
 }
 
 extern void freeKeywordTable (void)
 {
-	if (HashTable != NULL)
+	if (HashTables != NULL)
 	{
 		unsigned int i;
 
-		for (i = 0  ;  i < TableSize  ;  ++i)
+		for (i = 0  ;  i < HashTableCount  ;  ++i)
 		{
-			hashEntry *entry = HashTable [i];
-
-			while (entry != NULL)
-			{
-				hashEntry *next = entry->next;
-				eFree (entry);
-				entry = next;
-			}
+			if (HashTables [i].entries != NULL)
+				eFree (HashTables [i].entries);
 		}
-		eFree (HashTable);
+		eFree (HashTables);
+		HashTables = NULL;
+		HashTableCount = 0;
 	}
 }
 
 #ifdef DEBUG
 
-static void printEntry (const hashEntry *const entry)
+static void printTable (const langType language)
 {
-	printf ("  %-15s %-7s\n", entry->string, getLanguageName (entry->language));
-}
+	const hashTable *const table = &HashTables [language];
+	unsigned long probes = 0;
+	unsigned int i;
 
-static unsigned int printBucket (const unsigned int i)
-{
-	hashEntry **const table = getHashTable ();
-	hashEntry *entry = table [i];
-	unsigned int measure = 1;
-	bool first = true;
-
-	printf ("%2d:", i);
-	if (entry == NULL)
-		printf ("\n");
-	else while (entry != NULL)
+	for (i = 0  ;  i < table->size  ;  ++i)
 	{
-		if (! first)
-			printf ("    ");
-		else
+		const hashEntry *const entry = &table->entries [i];
+
+		if (entry->string != NULL)
 		{
-			printf (" ");
-			first = false;
+			const unsigned int home = entry->hash & (table->size - 1);
+
+			probes += ((i - home) & (table->size - 1)) + 1;
+			printf ("  %4u: %-15s %d\n", i, entry->string, entry->value);
 		}
-		printEntry (entry);
-		entry = entry->next;
-		measure = 2 * measure;
 	}
-	return measure - 1;
+	printf ("%s: %u keywords in %u slots, %.2f probes per lookup\n",
+			getLanguageName (language), table->count, table->size,
+			(double) probes / table->count);
 }
 
 extern void printKeywordTable (void)
 {
-	unsigned long emptyBucketCount = 0;
-	unsigned long measure = 0;
 	unsigned int i;
 
-	for (i = 0  ;  i < TableSize  ;  ++i)
+	for (i = 0  ;  i < HashTableCount  ;  ++i)
 	{
-		const unsigned int pass = printBucket (i);
-
-		measure += pass;
-		if (pass == 0)
-			++emptyBucketCount;
+		if (HashTables [i].count > 0)
+			printTable (i);
 	}
-
-	printf ("spread measure = %ld\n", measure);
-	printf ("%ld empty buckets\n", emptyBucketCount);
 }
 
 #endif
@@ -459,23 +459,18 @@ static Comment isComment (void)
  */
 int cppSkipOverCComment (void)
 {
-	int c = getcFromInputFile ();
+	int c;
 
-	while (c != EOF)
+	while ((c = skipToCharactersInInputFile ("*")) != EOF)
 	{
-		if (c != '*')
+		do
 			c = getcFromInputFile ();
-		else
-		{
-			const int next = getcFromInputFile ();
+		while (c == '*');
 
-			if (next != '/')
-				c = next;
-			else
-			{
-				c = SPACE;  /* replace comment with space */
-				break;
-			}
+		if (c == '/')
+		{
+			c = SPACE;  /* replace comment with space */
+			break;
 		}
 	}
 	return c;
@@ -487,7 +482,7 @@ static int skipOverCplusComment (void)
 {
 	int c;
 
-	while ((c = getcFromInputFile ()) != EOF)
+	while ((c = skipToCharactersInInputFile ("\\\n")) != EOF)
 	{
 		if (c == BACKSLASH)
 			getcFromInputFile ();  /* throw away next character, too */
@@ -502,23 +497,18 @@ static int skipOverCplusComment (void)
  */
 static int skipOverDComment (void)
 {
-	int c = getcFromInputFile ();
+	int c;
 
-	while (c != EOF)
+	while ((c = skipToCharactersInInputFile ("+")) != EOF)
 	{
-		if (c != '+')
+		do
 			c = getcFromInputFile ();
-		else
-		{
-			const int next = getcFromInputFile ();
+		while (c == '+');
 
-			if (next != '/')
-				c = next;
-			else
-			{
-				c = SPACE;  /* replace comment with space */
-				break;
-			}
+		if (c == '/')
+		{
+			c = SPACE;  /* replace comment with space */
+			break;
 		}
 	}
 	return c;
@@ -529,9 +519,10 @@ static int skipOverDComment (void)
  */
 static int skipToEndOfString (bool ignoreBackslash)
 {
+	const char *const ends = ignoreBackslash ? "\"" : "\\\"";
 	int c;
 
-	while ((c = getcFromInputFile ()) != EOF)
+	while ((c = skipToCharactersInInputFile (ends)) != EOF)
 	{
 		if (c == BACKSLASH && ! ignoreBackslash)
 			getcFromInputFile ();  /* throw away next character, too */
@@ -284,6 +284,35 @@ unsigned char *mio_memory_get_data (MIO *mio, size_t *size)
 	return ptr;
 }
 
+/**
+ * mio_memory_peek:
+ * @mio: A #MIO object
+ * @size: (out): Return location for the number of bytes left to read
+ *
+ * Gets the data of a #MIO memory stream that the next reads will return, so
+ * that it can be scanned in place rather than character by character.  The
+ * caller consumes what it used with mio_seek() relative to %SEEK_CUR.
+ *
+ * <warning><para>The returned pointer and size become invalid after any
+ * other operation on the stream.</para></warning>
+ *
+ * Returns: The unread data of the given #MIO stream, or %NULL if the stream is
+ *          not a memory stream or has a pending ungot character.
+ */
+const unsigned char *mio_memory_peek (MIO *mio, size_t *size)
+{
+	const unsigned char *ptr = NULL;
+
+	if (mio->type == MIO_TYPE_MEMORY && mio->impl.mem.ungetch == EOF &&
+		mio->impl.mem.pos <= mio->impl.mem.size)
+	{
+		ptr = mio->impl.mem.buf + mio->impl.mem.pos;
+		*size = mio->impl.mem.size - mio->impl.mem.pos;
+	}
+
+	return ptr;
+}
+
 /**
  * mio_free:
  * @mio: A #MIO object
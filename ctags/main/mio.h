@@ -148,6 +148,7 @@ MIO *mio_new_memory (unsigned char *data,
 int mio_free (MIO *mio);
 FILE *mio_file_get_fp (MIO *mio);
 unsigned char *mio_memory_get_data (MIO *mio, size_t *size);
+const unsigned char *mio_memory_peek (MIO *mio, size_t *size);
 size_t mio_read (MIO *mio,
 				 void *ptr,
 				 size_t size,
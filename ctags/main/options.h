@@ -100,6 +100,7 @@ extern void setDefaultTagFileName (void);
 extern bool isIncludeFile (const char *const fileName);
 extern bool isExcludedFile (const char* const name);
 extern bool isIgnoreToken (const char *const name, bool *const pIgnoreParens, const char **const replacement);
+extern char **c_tags_ignore;
 extern void readOptionConfiguration (void);
 extern void initOptions (void);
 extern void freeOptionResources (void);
@@ -430,6 +430,29 @@ extern void ungetcToInputFile (int c)
 		File.ungetchBuf[File.ungetchIdx++] = c;
 }
 
+/*  When reading from memory, appends the rest of the current line up to its
+ *  line break (or a NUL) in one go.  Only line breaks and line starts need the
+ *  processing iFileGetc () does, the characters in between are taken as is.
+ */
+static void iFileGetLineRun (vString *const line)
+{
+	size_t size;
+	size_t length = 0;
+	const unsigned char *const data = mio_memory_peek (File.mio, &size);
+
+	if (data == NULL)
+		return;
+	while (length < size  &&  data [length] != NEWLINE  &&
+		   data [length] != CRETURN  &&  data [length] != '\0')
+		length++;
+	if (length > 0)
+	{
+		DebugStatement ( { size_t i; for (i = 0; i < length; i++) debugPutc (DEBUG_RAW, data [i]); } )
+		vStringNCatS (line, (const char *) data, length);
+		mio_seek (File.mio, (long) length, SEEK_CUR);
+	}
+}
+
 static vString *iFileGetLine (void)
 {
 	vString *result = NULL;
@@ -442,6 +465,8 @@ static vString *iFileGetLine (void)
 		c = iFileGetc ();
 		if (c != EOF)
 			vStringPut (File.line, c);
+		if (c != EOF  &&  c != '\n')
+			iFileGetLineRun (File.line);
 		if (c == '\n'  ||  (c == EOF  &&  vStringLength (File.line) > 0))
 		{
 #ifdef HAVE_REGEX
@@ -517,6 +542,42 @@ extern int skipToCharacterInInputFile (int c)
 	return d;
 }
 
+/*  Like skipToCharacterInInputFile (), but stops at any of the characters in
+ *  chars.  The rest of the current line is searched as a whole rather than
+ *  getting its characters one by one, which makes skipping long comments and
+ *  strings cheap.
+ */
+extern int skipToCharactersInInputFile (const char *const chars)
+{
+	int c;
+
+	while (File.ungetchIdx > 0)
+	{
+		c = getcFromInputFile ();
+		if (c == EOF  ||  strchr (chars, c) != NULL)
+			return c;
+	}
+	do
+	{
+		if (File.currentLine != NULL)
+		{
+			const char *const found = strpbrk ((const char *) File.currentLine, chars);
+
+			if (found != NULL)
+			{
+				File.currentLine = (unsigned char *) found + 1;
+				c = (unsigned char) *found;
+				DebugStatement ( debugPutc (DEBUG_READ, c); )
+				return c;
+			}
+			/* nothing left on this line, go on with the next one */
+			File.currentLine = NULL;
+		}
+		c = getcFromInputFile ();
+	} while (c != EOF  &&  strchr (chars, c) == NULL);
+	return c;
+}
+
 /*  An alternative interface to getcFromInputFile (). Do not mix use of readLineFromInputFile()
  *  and getcFromInputFile() for the same file. The returned string does not contain
  *  the terminating newline. A NULL return value means that all lines in the
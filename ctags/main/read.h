@@ -109,6 +109,7 @@ extern void fileClose (void);
 extern int getcFromInputFile (void);
 extern int getNthPrevCFromInputFile (unsigned int nth, int def);
 extern int skipToCharacterInInputFile (int c);
+extern int skipToCharactersInInputFile (const char *const chars);
 extern void ungetcToInputFile (int c);
 extern const unsigned char *readLineFromInputFile (void);
 extern char *readLineRaw (vString *const vLine, MIO *const mio);
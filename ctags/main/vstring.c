@@ -136,15 +136,14 @@ extern vString *vStringNewInit (const char *const s)
 extern void vStringNCatS (
 		vString *const string, const char *const s, const size_t length)
 {
-	const char *p = s;
-	size_t remain = length;
+	const char *const nul = memchr (s, '\0', length);
+	const size_t len = (nul != NULL) ? (size_t) (nul - s) : length;
 
-	while (*p != '\0'  &&  remain > 0)
-	{
-		vStringPut (string, *p);
-		--remain;
-		++p;
-	}
+	while (string->length + len + 1 >= string->size)/*  check for buffer overflow */
+		vStringAutoResize (string);
+	memcpy (string->buffer + string->length, s, len);
+	string->length += len;
+	string->buffer [string->length] = '\0';
 }
 
 /*  Strip trailing newline from string.
@@ -12,6 +12,8 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <functional>
+#include <algorithm>
 #include <sstream>
 
 #include <glib.h>
@@ -76,6 +78,106 @@ using namespace Scintilla;
 
 enum encodingType { singleByte, UTF8, dbcs};
 
+class FontHandle;
+
+// Shaped layouts of recently drawn text, so that repainting text that hasn't
+// changed doesn't convert and shape it again.
+// The entries of a font are dropped when it is released which happens whenever
+// the styles are refreshed, at the same time as the line layouts are invalidated.
+class LayoutCache {
+	struct Key {
+		const FontHandle *font;
+		int encoding;
+		std::string text;
+		Key(const FontHandle *font_, int encoding_, const char *s, int len) :
+			font(font_), encoding(encoding_), text(s, len) {
+		}
+		bool operator<(const Key &other) const {
+			if (font != other.font)
+				return std::less<const FontHandle *>()(font, other.font);
+			if (encoding != other.encoding)
+				return encoding < other.encoding;
+			return text < other.text;
+		}
+	};
+	struct Entry {
+		PangoLayout *layout;
+		unsigned int clock;
+	};
+	typedef std::map<Key, Entry> EntryMap;
+	EntryMap entries;
+	unsigned int clock;
+	void DropOldest();
+public:
+	enum { maxEntries = 1000 };
+	LayoutCache() : clock(0) {
+	}
+	~LayoutCache();
+	PangoLayout *Find(const FontHandle *font, int encoding, const char *s, int len);
+	void Add(const FontHandle *font, int encoding, const char *s, int len, PangoLayout *layout);
+	void ReleaseFont(const FontHandle *font);
+};
+
+static LayoutCache *layoutCache = 0;
+
+LayoutCache::~LayoutCache() {
+	for (EntryMap::iterator it = entries.begin(); it != entries.end(); ++it) {
+		g_object_unref(it->second.layout);
+	}
+}
+
+// Drop the least recently used half of the entries.
+void LayoutCache::DropOldest() {
+	std::vector<unsigned int> clocks;
+	clocks.reserve(entries.size());
+	for (EntryMap::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+		clocks.push_back(it->second.clock);
+	}
+	std::vector<unsigned int>::iterator median = clocks.begin() + clocks.size() / 2;
+	std::nth_element(clocks.begin(), median, clocks.end());
+	const unsigned int clockKeep = *median;
+	for (EntryMap::iterator it = entries.begin(); it != entries.end();) {
+		if (it->second.clock < clockKeep) {
+			g_object_unref(it->second.layout);
+			entries.erase(it++);
+		} else {
+			++it;
+		}
+	}
+}
+
+PangoLayout *LayoutCache::Find(const FontHandle *font, int encoding, const char *s, int len) {
+	EntryMap::iterator it = entries.find(Key(font, encoding, s, len));
+	if (it == entries.end())
+		return 0;
+	it->second.clock = ++clock;
+	return it->second.layout;
+}
+
+// Takes a reference to the layout.
+void LayoutCache::Add(const FontHandle *font, int encoding, const char *s, int len, PangoLayout *layout) {
+	if (entries.size() >= maxEntries)
+		DropOldest();
+	Entry entry;
+	entry.layout = static_cast<PangoLayout *>(g_object_ref(layout));
+	entry.clock = ++clock;
+	std::pair<EntryMap::iterator, bool> inserted =
+		entries.insert(std::make_pair(Key(font, encoding, s, len), entry));
+	if (!inserted.second) {
+		g_object_unref(inserted.first->second.layout);
+		inserted.first->second = entry;
+	}
+}
+
+void LayoutCache::ReleaseFont(const FontHandle *font) {
+	// Entries are ordered by font first so those of the font are together
+	EntryMap::iterator it = entries.lower_bound(Key(font, -1, "", 0));
+	while ((it != entries.end()) && (it->first.font == font)) {
+		g_object_unref(it->second.layout);
+		entries.erase(it++);
+	}
+}
+
 // Holds a PangoFontDescription*.
 class FontHandle {
 public:
@@ -88,6 +190,8 @@ public:
 		characterSet = characterSet_;
 	}
 	~FontHandle() {
+		if (layoutCache)
+			layoutCache->ReleaseFont(this);
 		if (pfd)
 			pango_font_description_free(pfd);
 		pfd = 0;
@@ -687,23 +791,32 @@ void SurfaceImpl::DrawTextBase(PRectangle rc, Font &font_, XYPOSITION ybase, con
 	if (context) {
 		XYPOSITION xText = rc.left;
 		if (PFont(font_)->pfd) {
-			std::string utfForm;
-			if (et == UTF8) {
-				pango_layout_set_text(layout, s, len);
-			} else {
-				SetConverter(PFont(font_)->characterSet);
-				utfForm = UTF8FromIconv(conv, s, len);
-				if (utfForm.empty()) {	// iconv failed so treat as Latin1
-					utfForm = UTF8FromLatin1(s, len);
+			if (!layoutCache)
+				layoutCache = new LayoutCache();
+			PangoLayout *layoutText = layoutCache->Find(PFont(font_), et, s, len);
+			if (!layoutText) {
+				layoutText = pango_layout_new(pcontext);
+				std::string utfForm;
+				if (et == UTF8) {
+					pango_layout_set_text(layoutText, s, len);
+				} else {
+					SetConverter(PFont(font_)->characterSet);
+					utfForm = UTF8FromIconv(conv, s, len);
+					if (utfForm.empty()) {	// iconv failed so treat as Latin1
+						utfForm = UTF8FromLatin1(s, len);
+					}
+					pango_layout_set_text(layoutText, utfForm.c_str(), utfForm.length());
 				}
-				pango_layout_set_text(layout, utfForm.c_str(), utfForm.length());
+				pango_layout_set_font_description(layoutText, PFont(font_)->pfd);
+				layoutCache->Add(PFont(font_), et, s, len, layoutText);
+				g_object_unref(layoutText);
 			}
-			pango_layout_set_font_description(layout, PFont(font_)->pfd);
-			pango_cairo_update_layout(context, layout);
+			// Only lays the text out again if the cairo context has different font options
+			pango_cairo_update_layout(context, layoutText);
 #ifdef PANGO_VERSION
-			PangoLayoutLine *pll = pango_layout_get_line_readonly(layout,0);
+			PangoLayoutLine *pll = pango_layout_get_line_readonly(layoutText,0);
 #else
-			PangoLayoutLine *pll = pango_layout_get_line(layout,0);
+			PangoLayoutLine *pll = pango_layout_get_line(layoutText,0);
 #endif
 			cairo_move_to(context, xText, ybase);
 			pango_cairo_show_layout_line(context, pll);
@@ -2151,4 +2264,6 @@ void Platform_Initialise() {
 }
 
 void Platform_Finalise() {
+	delete layoutCache;
+	layoutCache = 0;
 }
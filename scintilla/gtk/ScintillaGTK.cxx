@@ -174,7 +174,8 @@ ScintillaGTK::ScintillaGTK(_ScintillaObject *sci_) :
 		rgnUpdate(0),
 		repaintFullWindow(false),
 		styleIdleID(0),
-		accessible(0) {
+		accessible(0),
+		accessibilityCoalescing(false) {
 	sci = sci_;
 	wMain = GTK_WIDGET(sci);
 
@@ -863,6 +864,13 @@ sptr_t ScintillaGTK::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam
 		case SCI_GETRECTANGULARSELECTIONMODIFIER:
 			return rectangularSelectionModifier;
 
+		case SCI_SETACCESSIBILITYCOALESCING:
+			accessibilityCoalescing = wParam != 0;
+			break;
+
+		case SCI_GETACCESSIBILITYCOALESCING:
+			return accessibilityCoalescing;
+
 		case SCI_SETREADONLY: {
 			sptr_t ret = ScintillaBase::WndProc(iMessage, wParam, lParam);
 			if (accessible) {
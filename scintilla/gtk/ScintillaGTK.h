@@ -69,6 +69,7 @@ class ScintillaGTK : public ScintillaBase {
 
 	guint styleIdleID;
 	AtkObject *accessible;
+	bool accessibilityCoalescing;
 
 	// Private so ScintillaGTK objects can not be copied
 	ScintillaGTK(const ScintillaGTK &);
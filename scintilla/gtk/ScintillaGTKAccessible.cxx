@@ -157,13 +157,22 @@ ScintillaGTKAccessible::ScintillaGTKAccessible(GtkAccessible *accessible_, GtkWi
 		accessible(accessible_),
 		sci(ScintillaGTK::FromWidget(widget_)),
 		deletionLengthChar(0),
-		old_pos(-1) {
+		old_pos(-1),
+		changesIdleID(0),
+		changeStart(0), changeEnd(0),
+		changeStartChar(0), changeDeletedChars(0) {
 	g_signal_connect(widget_, "sci-notify", G_CALLBACK(SciNotify), this);
+	sci->pdoc->AllocateLineCharacterIndex(SC_LINECHARACTERINDEX_UTF32);
 }
 
 ScintillaGTKAccessible::~ScintillaGTKAccessible() {
+	if (changesIdleID) {
+		g_source_remove(changesIdleID);
+	}
 	if (gtk_accessible_get_widget(accessible)) {
 		g_signal_handlers_disconnect_matched(sci->sci, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, this);
+		// otherwise the widget, and usually its document, is already being destroyed
+		sci->pdoc->ReleaseLineCharacterIndex(SC_LINECHARACTERINDEX_UTF32);
 	}
 }
 
@@ -823,13 +832,21 @@ void ScintillaGTKAccessible::ChangeDocument(Document *oldDoc, Document *newDoc)
 		return;
 	}
 
+	if (changesIdleID) {
+		// report the pending changes against the document they happened in
+		FlushChanges(oldDoc ? oldDoc : newDoc);
+	}
+	character_offsets.clear();
+
 	if (oldDoc) {
 		int charLength = oldDoc->CountCharacters(0, oldDoc->Length());
 		g_signal_emit_by_name(accessible, "text-changed::delete", 0, charLength);
+		oldDoc->ReleaseLineCharacterIndex(SC_LINECHARACTERINDEX_UTF32);
 	}
 
 	if (newDoc) {
 		PLATFORM_ASSERT(newDoc == sci->pdoc);
+		newDoc->AllocateLineCharacterIndex(SC_LINECHARACTERINDEX_UTF32);
 
 		int charLength = newDoc->CountCharacters(0, newDoc->Length());
 		g_signal_emit_by_name(accessible, "text-changed::insert", 0, charLength);
@@ -853,9 +870,91 @@ void ScintillaGTKAccessible::NotifyReadOnly() {
 #endif
 }
 
+// Coalescing modifications
+// The changes are collected into a single range which is reported as one deletion of the
+// text it replaced followed by one insertion of its current text, once the main loop is
+// idle. Most of the character counting is done on the unchanged text around the range
+// through the character offset cache.
+
+void ScintillaGTKAccessible::AddInsertion(Position position, Position length) {
+	if (!changesIdleID) {
+		changeStart = position;
+		changeEnd = position + length;
+		changeStartChar = CharacterOffsetFromByteOffset(position);
+		changeDeletedChars = 0;
+		changesIdleID = gdk_threads_add_idle_full(G_PRIORITY_HIGH_IDLE, ChangesIdle, this, NULL);
+	} else if (position < changeStart) {
+		// unchanged text between the insertion and the range joins the range
+		changeDeletedChars += CharacterCount(position + length, changeStart + length);
+		changeStartChar = CharacterOffsetFromByteOffset(position);
+		changeStart = position;
+		changeEnd += length;
+	} else if (position > changeEnd) {
+		changeDeletedChars += CharacterCount(changeEnd, position);
+		changeEnd = position + length;
+	} else {
+		changeEnd += length;
+	}
+}
+
+// Called before the text is deleted, so that it can be counted
+void ScintillaGTKAccessible::AddDeletion(Position position, Position length) {
+	const Position end = position + length;
+	if (!changesIdleID) {
+		changeStart = position;
+		changeEnd = end;
+		changeStartChar = CharacterOffsetFromByteOffset(position);
+		changeDeletedChars = CharacterCount(position, end);
+		changesIdleID = gdk_threads_add_idle_full(G_PRIORITY_HIGH_IDLE, ChangesIdle, this, NULL);
+	} else {
+		// unchanged text between the deletion and the range joins the range
+		if (position < changeStart) {
+			changeDeletedChars += CharacterCount(position, changeStart);
+			changeStartChar = CharacterOffsetFromByteOffset(position);
+			changeStart = position;
+		}
+		if (end > changeEnd) {
+			changeDeletedChars += CharacterCount(changeEnd, end);
+			changeEnd = end;
+		}
+	}
+	changeEnd -= length;
+}
+
+void ScintillaGTKAccessible::FlushChanges(Document *doc) {
+	if (changesIdleID) {
+		g_source_remove(changesIdleID);
+		changesIdleID = 0;
+	}
+	if (changeDeletedChars > 0) {
+		g_signal_emit_by_name(accessible, "text-changed::delete", changeStartChar, changeDeletedChars);
+	}
+	const int insertedChars = (doc == sci->pdoc) ?
+		CharacterCount(changeStart, changeEnd) : doc->CountCharacters(changeStart, changeEnd);
+	if (insertedChars > 0) {
+		g_signal_emit_by_name(accessible, "text-changed::insert", changeStartChar, insertedChars);
+	}
+	if (doc == sci->pdoc) {
+		UpdateCursor();
+	}
+}
+
+gboolean ScintillaGTKAccessible::ChangesIdle(gpointer data) {
+	ScintillaGTKAccessible *scia = static_cast<ScintillaGTKAccessible *>(data);
+	try {
+		// the source is removed by returning FALSE
+		scia->changesIdleID = 0;
+		scia->FlushChanges(scia->sci->pdoc);
+	} catch (...) {}
+	return FALSE;
+}
+
 void ScintillaGTKAccessible::Notify(GtkWidget *, gint, SCNotification *nt) {
 	switch (nt->nmhdr.code) {
 		case SCN_MODIFIED: {
+			if (changesIdleID && !sci->accessibilityCoalescing) {
+				FlushChanges(sci->pdoc);
+			}
 			if (nt->modificationType & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT)) {
 				// invalidate character offset cache if applicable
 				const Position line = sci->pdoc->LineFromPosition(nt->position);
@@ -863,22 +962,31 @@ void ScintillaGTKAccessible::Notify(GtkWidget *, gint, SCNotification *nt) {
 					character_offsets.resize(line + 1);
 				}
 			}
-			if (nt->modificationType & SC_MOD_INSERTTEXT) {
-				int startChar = CharacterOffsetFromByteOffset(nt->position);
-				int lengthChar = sci->pdoc->CountCharacters(nt->position, nt->position + nt->length);
-				g_signal_emit_by_name(accessible, "text-changed::insert", startChar, lengthChar);
-				UpdateCursor();
-			}
-			if (nt->modificationType & SC_MOD_BEFOREDELETE) {
-				// We cannot compute the deletion length in DELETETEXT as it requires accessing the
-				// buffer, so that the character are still present.  So, we cache the value here,
-				// and use it in DELETETEXT that fires quickly after.
-				deletionLengthChar = sci->pdoc->CountCharacters(nt->position, nt->position + nt->length);
-			}
-			if (nt->modificationType & SC_MOD_DELETETEXT) {
-				int startChar = CharacterOffsetFromByteOffset(nt->position);
-				g_signal_emit_by_name(accessible, "text-changed::delete", startChar, deletionLengthChar);
-				UpdateCursor();
+			if (sci->accessibilityCoalescing) {
+				if (nt->modificationType & SC_MOD_INSERTTEXT) {
+					AddInsertion(nt->position, nt->length);
+				}
+				if (nt->modificationType & SC_MOD_BEFOREDELETE) {
+					AddDeletion(nt->position, nt->length);
+				}
+			} else {
+				if (nt->modificationType & SC_MOD_INSERTTEXT) {
+					int startChar = CharacterOffsetFromByteOffset(nt->position);
+					int lengthChar = sci->pdoc->CountCharacters(nt->position, nt->position + nt->length);
+					g_signal_emit_by_name(accessible, "text-changed::insert", startChar, lengthChar);
+					UpdateCursor();
+				}
+				if (nt->modificationType & SC_MOD_BEFOREDELETE) {
+					// We cannot compute the deletion length in DELETETEXT as it requires accessing the
+					// buffer, so that the character are still present.  So, we cache the value here,
+					// and use it in DELETETEXT that fires quickly after.
+					deletionLengthChar = sci->pdoc->CountCharacters(nt->position, nt->position + nt->length);
+				}
+				if (nt->modificationType & SC_MOD_DELETETEXT) {
+					int startChar = CharacterOffsetFromByteOffset(nt->position);
+					g_signal_emit_by_name(accessible, "text-changed::delete", startChar, deletionLengthChar);
+					UpdateCursor();
+				}
 			}
 			if (nt->modificationType & SC_MOD_CHANGESTYLE) {
 				g_signal_emit_by_name(accessible, "text-attributes-changed");
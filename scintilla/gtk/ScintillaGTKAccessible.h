@@ -29,7 +29,19 @@ private:
 	Position old_pos;
 	std::vector<SelectionRange> old_sels;
 
+	// modifications not reported yet when coalescing: the range changed since the last
+	// report, in bytes of the current text, and what it replaces in the reported text
+	guint changesIdleID;
+	Position changeStart;
+	Position changeEnd;
+	int changeStartChar;
+	int changeDeletedChars;
+
 	void UpdateCursor();
+	void AddInsertion(Position position, Position length);
+	void AddDeletion(Position position, Position length);
+	void FlushChanges(Document *doc);
+	static gboolean ChangesIdle(gpointer data);
 	void Notify(GtkWidget *widget, gint code, SCNotification *nt);
 	static void SciNotify(GtkWidget *widget, gint code, SCNotification *nt, gpointer data) {
 		try {
@@ -56,6 +68,12 @@ private:
 
 	int CharacterOffsetFromByteOffset(Position byteOffset) {
 		const Position line = sci->pdoc->LineFromPosition(byteOffset);
+		if (sci->pdoc->LineCharacterIndex() & SC_LINECHARACTERINDEX_UTF32) {
+			// UTF-8 documents keep the character offset of each line start for us
+			const Position lineStart = sci->pdoc->LineStart(line);
+			return sci->pdoc->IndexLineStart(line, SC_LINECHARACTERINDEX_UTF32) +
+				sci->pdoc->CountCharacters(lineStart, byteOffset);
+		}
 		if (character_offsets.size() <= static_cast<size_t>(line)) {
 			if (character_offsets.empty())
 				character_offsets.push_back(0);
@@ -69,6 +87,11 @@ private:
 		return character_offsets[line] + sci->pdoc->CountCharacters(lineStart, byteOffset);
 	}
 
+	// Uses the character offset cache, so cheap for ranges spanning many lines
+	int CharacterCount(Position startByte, Position endByte) {
+		return CharacterOffsetFromByteOffset(endByte) - CharacterOffsetFromByteOffset(startByte);
+	}
+
 	void CharacterRangeFromByteRange(Position startByte, Position endByte, int *startChar, int *endChar) {
 		*startChar = CharacterOffsetFromByteOffset(startByte);
 		*endChar = *startChar + sci->pdoc->CountCharacters(startByte, endByte);
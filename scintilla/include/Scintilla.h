@@ -430,6 +430,9 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SCI_CANPASTE 2173
 #define SCI_CANUNDO 2174
 #define SCI_EMPTYUNDOBUFFER 2175
+#define SCI_GETUNDOMEMORYUSAGE 2950
+#define SCI_SETUNDOMEMORYLIMIT 2951
+#define SCI_GETUNDOMEMORYLIMIT 2952
 #define SCI_UNDO 2176
 #define SCI_CUT 2177
 #define SCI_COPY 2178
@@ -528,6 +531,8 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SC_IDLESTYLING_ALL 3
 #define SCI_SETIDLESTYLING 2692
 #define SCI_GETIDLESTYLING 2693
+#define SCI_SETSTYLINGCONVERGENCE 2957
+#define SCI_GETSTYLINGCONVERGENCE 2958
 #define SC_WRAP_NONE 0
 #define SC_WRAP_WORD 1
 #define SC_WRAP_CHAR 2
@@ -747,6 +752,14 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SCI_POSITIONBEFORE 2417
 #define SCI_POSITIONAFTER 2418
 #define SCI_POSITIONRELATIVE 2670
+#define SC_LINECHARACTERINDEX_NONE 0
+#define SC_LINECHARACTERINDEX_UTF32 1
+#define SC_LINECHARACTERINDEX_UTF16 2
+#define SCI_GETLINECHARACTERINDEX 2710
+#define SCI_ALLOCATELINECHARACTERINDEX 2711
+#define SCI_RELEASELINECHARACTERINDEX 2712
+#define SCI_LINEFROMINDEXPOSITION 2713
+#define SCI_INDEXPOSITIONFROMLINE 2714
 #define SCI_COPYRANGE 2419
 #define SCI_COPYTEXT 2420
 #define SC_SEL_STREAM 0
@@ -830,6 +843,8 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SCI_INDICATOREND 2509
 #define SCI_SETPOSITIONCACHE 2514
 #define SCI_GETPOSITIONCACHE 2515
+#define SCI_GETPOSITIONCACHEHITS 2953
+#define SCI_GETPOSITIONCACHEMISSES 2954
 #define SCI_COPYALLOWLINE 2519
 #define SCI_GETCHARACTERPOINTER 2520
 #define SCI_GETRANGEPOINTER 2643
@@ -924,6 +939,8 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SCI_GETVIRTUALSPACEOPTIONS 2597
 #define SCI_SETRECTANGULARSELECTIONMODIFIER 2598
 #define SCI_GETRECTANGULARSELECTIONMODIFIER 2599
+#define SCI_SETACCESSIBILITYCOALESCING 2955
+#define SCI_GETACCESSIBILITYCOALESCING 2956
 #define SCI_SETADDITIONALSELFORE 2600
 #define SCI_SETADDITIONALSELBACK 2601
 #define SCI_SETADDITIONALSELALPHA 2602
@@ -11,6 +11,7 @@
 #include <stdarg.h>
 
 #include <stdexcept>
+#include <vector>
 #include <algorithm>
 
 #include "Platform.h"
@@ -26,6 +27,12 @@
 using namespace Scintilla;
 #endif
 
+void LineStartIndex::SetLineWidth(int line, int width) {
+	const int widthCurrent = starts.PositionFromPartition(line+1) - starts.PositionFromPartition(line);
+	if (width != widthCurrent)
+		starts.InsertText(line, width - widthCurrent);
+}
+
 LineVector::LineVector() : starts(256), perLine(0) {
 	Init();
 }
@@ -36,6 +43,8 @@ LineVector::~LineVector() {
 
 void LineVector::Init() {
 	starts.DeleteAll();
+	startsUTF32.starts.DeleteAll();
+	startsUTF16.starts.DeleteAll();
 	if (perLine) {
 		perLine->Init();
 	}
@@ -51,6 +60,11 @@ void LineVector::InsertText(int line, int delta) {
 
 void LineVector::InsertLine(int line, int position, bool lineStart) {
 	starts.InsertPartition(line, position);
+	// New lines start out empty, widths are filled in by CellBuffer after the change
+	if (startsUTF32.Active())
+		startsUTF32.starts.InsertPartition(line, startsUTF32.starts.PositionFromPartition(line));
+	if (startsUTF16.Active())
+		startsUTF16.starts.InsertPartition(line, startsUTF16.starts.PositionFromPartition(line));
 	if (perLine) {
 		if ((line > 0) && lineStart)
 			line--;
@@ -64,6 +78,10 @@ void LineVector::SetLineStart(int line, int position) {
 
 void LineVector::RemoveLine(int line) {
 	starts.RemovePartition(line);
+	if (startsUTF32.Active())
+		startsUTF32.starts.RemovePartition(line);
+	if (startsUTF16.Active())
+		startsUTF16.starts.RemovePartition(line);
 	if (perLine) {
 		perLine->RemoveLine(line);
 	}
@@ -73,6 +91,138 @@ int LineVector::LineFromPosition(int pos) const {
 	return starts.PartitionFromPosition(pos);
 }
 
+int LineVector::LineCharacterIndex() const {
+	int lineCharacterIndex = SC_LINECHARACTERINDEX_NONE;
+	if (startsUTF32.Active())
+		lineCharacterIndex |= SC_LINECHARACTERINDEX_UTF32;
+	if (startsUTF16.Active())
+		lineCharacterIndex |= SC_LINECHARACTERINDEX_UTF16;
+	return lineCharacterIndex;
+}
+
+static bool AllocateIndex(LineStartIndex &index, int lines) {
+	index.refCount++;
+	if (index.refCount > 1)
+		return false;
+	// One empty partition per line, the caller then measures every line
+	index.starts.DeleteAll();
+	for (int line = 1; line < lines; line++)
+		index.starts.InsertPartition(line, 0);
+	return true;
+}
+
+static void ReleaseIndex(LineStartIndex &index) {
+	if (index.refCount > 0) {
+		index.refCount--;
+		if (index.refCount == 0)
+			index.starts.DeleteAll();
+	}
+}
+
+// Returns true when an index was created and so needs to be filled in.
+bool LineVector::AllocateLineCharacterIndex(int lineCharacterIndex) {
+	bool created = false;
+	if (lineCharacterIndex & SC_LINECHARACTERINDEX_UTF32)
+		created = AllocateIndex(startsUTF32, Lines()) || created;
+	if (lineCharacterIndex & SC_LINECHARACTERINDEX_UTF16)
+		created = AllocateIndex(startsUTF16, Lines()) || created;
+	return created;
+}
+
+void LineVector::ReleaseLineCharacterIndex(int lineCharacterIndex) {
+	if (lineCharacterIndex & SC_LINECHARACTERINDEX_UTF32)
+		ReleaseIndex(startsUTF32);
+	if (lineCharacterIndex & SC_LINECHARACTERINDEX_UTF16)
+		ReleaseIndex(startsUTF16);
+}
+
+void LineVector::SetLineCharactersWidth(int line, int widthUTF32, int widthUTF16) {
+	if (startsUTF32.Active())
+		startsUTF32.SetLineWidth(line, widthUTF32);
+	if (startsUTF16.Active())
+		startsUTF16.SetLineWidth(line, widthUTF16);
+}
+
+void LineVector::InsertCharacters(int line, int deltaUTF32, int deltaUTF16) {
+	if (startsUTF32.Active())
+		startsUTF32.starts.InsertText(line, deltaUTF32);
+	if (startsUTF16.Active())
+		startsUTF16.starts.InsertText(line, deltaUTF16);
+}
+
+int LineVector::IndexLineStart(int line, int lineCharacterIndex) const {
+	if (lineCharacterIndex == SC_LINECHARACTERINDEX_UTF32)
+		return startsUTF32.starts.PositionFromPartition(line);
+	else
+		return startsUTF16.starts.PositionFromPartition(line);
+}
+
+int LineVector::LineFromPositionIndex(int pos, int lineCharacterIndex) const {
+	if (lineCharacterIndex == SC_LINECHARACTERINDEX_UTF32)
+		return startsUTF32.starts.PartitionFromPosition(pos);
+	else
+		return startsUTF16.starts.PartitionFromPosition(pos);
+}
+
+UndoLog::UndoLog() : allocated(0) {
+}
+
+UndoLog::~UndoLog() {
+	Truncate(UndoLogPosition());
+	if (!chunks.empty()) {
+		delete []chunks[0].text;
+		chunks.clear();
+	}
+}
+
+const char *UndoLog::Append(const char *s, int length) {
+	// Most actions are single characters from typing so collect them in chunks
+	const int chunkSize = 0x10000;
+	if (length <= 0)
+		return 0;
+	if (chunks.empty() || (chunks.back().used + length > chunks.back().size)) {
+		Chunk chunk;
+		chunk.size = (length > chunkSize) ? length : chunkSize;
+		chunk.text = new char[chunk.size];
+		chunk.used = 0;
+		chunks.push_back(chunk);
+		allocated += chunk.size;
+	}
+	Chunk &last = chunks.back();
+	char *text = last.text + last.used;
+	memcpy(text, s, length);
+	last.used += length;
+	return text;
+}
+
+UndoLogPosition UndoLog::End() const {
+	UndoLogPosition end;
+	if (!chunks.empty()) {
+		end.chunk = static_cast<int>(chunks.size()) - 1;
+		end.offset = chunks.back().used;
+	}
+	return end;
+}
+
+void UndoLog::Truncate(UndoLogPosition end) {
+	// Keep the chunk containing the end, even when empty, to reuse it
+	while (static_cast<int>(chunks.size()) > end.chunk + 1) {
+		allocated -= chunks.back().size;
+		delete []chunks.back().text;
+		chunks.pop_back();
+	}
+	if (!chunks.empty())
+		chunks.back().used = end.offset;
+}
+
+void UndoLog::DropFirstChunk() {
+	if (!chunks.empty()) {
+		allocated -= chunks.front().size;
+		delete []chunks.front().text;
+		chunks.erase(chunks.begin());
+	}
+}
+
 Action::Action() {
 	at = startAction;
 	position = 0;
@@ -81,36 +231,21 @@ Action::Action() {
 	mayCoalesce = false;
 }
 
-Action::~Action() {
-	Destroy();
-}
-
 void Action::Create(actionType at_, int position_, const char *data_, int lenData_, bool mayCoalesce_) {
-	delete []data;
-	data = NULL;
 	position = position_;
 	at = at_;
-	if (lenData_) {
-		data = new char[lenData_];
-		memcpy(data, data_, lenData_);
-	}
+	data = data_;
 	lenData = lenData_;
 	mayCoalesce = mayCoalesce_;
 }
 
-void Action::Destroy() {
-	delete []data;
-	data = 0;
-}
-
 void Action::Grab(Action *source) {
-	delete []data;
-
 	position = source->position;
 	at = source->at;
 	data = source->data;
 	lenData = source->lenData;
 	mayCoalesce = source->mayCoalesce;
+	logEnd = source->logEnd;
 
 	// Ownership of source data transferred to this
 	source->position = 0;
@@ -147,8 +282,9 @@ UndoHistory::UndoHistory() {
 	undoSequenceDepth = 0;
 	savePoint = 0;
 	tentativePoint = -1;
+	memoryLimit = 0;
 
-	actions[currentAction].Create(startAction);
+	CreateAction(currentAction, startAction);
 }
 
 UndoHistory::~UndoHistory() {
@@ -171,6 +307,54 @@ void UndoHistory::EnsureUndoRoom() {
 	}
 }
 
+// Actions are created in order so the text of the actions before act ends the log and
+// all the text after it belongs to actions being discarded.
+void UndoHistory::CreateAction(int act, actionType at, int position, const char *data, int lenData, bool mayCoalesce) {
+	log.Truncate((act > 0) ? actions[act - 1].logEnd : UndoLogPosition());
+	actions[act].Create(at, position, log.Append(data, lenData), lenData, mayCoalesce);
+	actions[act].logEnd = log.End();
+}
+
+// Drop the oldest user operations so the first chunk of the log can be freed.
+// With a single chunk, whose text is still needed, drop the oldest quarter of the
+// actions instead as their records may be what is using the memory.
+// Returns false if that isn't possible without touching the current operation.
+bool UndoHistory::DropOldestActions() {
+	if (undoSequenceDepth > 0 || TentativeActive())
+		return false;
+	const bool dropChunk = log.Chunks() >= 2;
+	// First action whose text isn't in the first chunk
+	int act = 1;
+	if (dropChunk) {
+		while ((act < currentAction) && (actions[act].logEnd.chunk == 0))
+			act++;
+	} else if (currentAction / 4 > act) {
+		act = currentAction / 4;
+	}
+	// Drop whole user operations, up to the start action before the next one
+	while ((act < currentAction) && (actions[act].at != startAction))
+		act++;
+	if (act >= currentAction)
+		return false;
+
+	for (int a = act; a <= maxAction; a++)
+		actions[a - act].Grab(&actions[a]);
+	currentAction -= act;
+	maxAction -= act;
+	savePoint = (savePoint >= act) ? savePoint - act : -1;
+	if (dropChunk) {
+		log.DropFirstChunk();
+		for (int a = 0; a <= maxAction; a++)
+			actions[a].logEnd.chunk--;
+	}
+	return true;
+}
+
+void UndoHistory::TrimHistory() {
+	while (memoryLimit && (MemoryUsage() > memoryLimit) && DropOldestActions()) {
+	}
+}
+
 const char *UndoHistory::AppendAction(actionType at, int position, const char *data, int lengthData,
 	bool &startSequence, bool mayCoalesce) {
 	EnsureUndoRoom();
@@ -239,12 +423,15 @@ const char *UndoHistory::AppendAction(actionType at, int position, const char *d
 		currentAction++;
 	}
 	startSequence = oldCurrentAction != currentAction;
-	int actionWithData = currentAction;
-	actions[currentAction].Create(at, position, data, lengthData, mayCoalesce);
+	const char *dataStored;
+	CreateAction(currentAction, at, position, data, lengthData, mayCoalesce);
+	dataStored = actions[currentAction].data;
 	currentAction++;
-	actions[currentAction].Create(startAction);
+	CreateAction(currentAction, startAction);
 	maxAction = currentAction;
-	return actions[actionWithData].data;
+	// Only operations before the new action are dropped so dataStored stays valid
+	TrimHistory();
+	return dataStored;
 }
 
 void UndoHistory::BeginUndoAction() {
@@ -252,7 +439,7 @@ void UndoHistory::BeginUndoAction() {
 	if (undoSequenceDepth == 0) {
 		if (actions[currentAction].at != startAction) {
 			currentAction++;
-			actions[currentAction].Create(startAction);
+			CreateAction(currentAction, startAction);
 			maxAction = currentAction;
 		}
 		actions[currentAction].mayCoalesce = false;
@@ -267,10 +454,11 @@ void UndoHistory::EndUndoAction() {
 	if (0 == undoSequenceDepth) {
 		if (actions[currentAction].at != startAction) {
 			currentAction++;
-			actions[currentAction].Create(startAction);
+			CreateAction(currentAction, startAction);
 			maxAction = currentAction;
 		}
 		actions[currentAction].mayCoalesce = false;
+		TrimHistory();
 	}
 }
 
@@ -279,11 +467,9 @@ void UndoHistory::DropUndoSequence() {
 }
 
 void UndoHistory::DeleteUndoHistory() {
-	for (int i = 1; i < maxAction; i++)
-		actions[i].Destroy();
 	maxAction = 0;
 	currentAction = 0;
-	actions[currentAction].Create(startAction);
+	CreateAction(currentAction, startAction);
 	savePoint = 0;
 	tentativePoint = -1;
 }
@@ -366,9 +552,21 @@ void UndoHistory::CompletedRedoStep() {
 	currentAction++;
 }
 
+void UndoHistory::SetMemoryLimit(size_t limit) {
+	memoryLimit = limit;
+	TrimHistory();
+}
+
+// The text chunks of the log plus the actions in use; spare capacity of the
+// actions array is not counted so the figure only shrinks as history is dropped.
+size_t UndoHistory::MemoryUsage() const {
+	return log.MemoryUsage() + (maxAction + 1) * sizeof(Action);
+}
+
 CellBuffer::CellBuffer() {
 	readOnly = false;
 	utf8LineEnds = 0;
+	utf8Substance = false;
 	collectingUndo = true;
 }
 
@@ -421,6 +619,10 @@ int CellBuffer::GapPosition() const {
 	return substance.GapPosition();
 }
 
+const char *CellBuffer::ContiguousRangePointer(int position, int &rangeLength) const {
+	return substance.ContiguousRangePointer(position, rangeLength);
+}
+
 // The char* returned is to an allocation owned by the undo history
 const char *CellBuffer::InsertString(int position, const char *s, int insertLength, bool &startSequence) {
 	// InsertString and DeleteChars are the bottleneck though which all changes occur
@@ -496,6 +698,13 @@ void CellBuffer::SetLineEndTypes(int utf8LineEnds_) {
 	}
 }
 
+void CellBuffer::SetUTF8Substance(bool utf8Substance_) {
+	if (utf8Substance != utf8Substance_) {
+		utf8Substance = utf8Substance_;
+		RecalculateIndexLineStarts(0, Lines() - 1);
+	}
+}
+
 bool CellBuffer::ContainsLineEnd(const char *s, int length) const {
 	unsigned char chBeforePrev = 0;
 	unsigned char chPrev = 0;
@@ -574,6 +783,85 @@ void CellBuffer::RemoveLine(int line) {
 	lv.RemoveLine(line);
 }
 
+int CellBuffer::LineCharacterIndex() const {
+	return lv.LineCharacterIndex();
+}
+
+void CellBuffer::AllocateLineCharacterIndex(int lineCharacterIndex) {
+	if (lv.AllocateLineCharacterIndex(lineCharacterIndex)) {
+		RecalculateIndexLineStarts(0, Lines() - 1);
+	}
+}
+
+void CellBuffer::ReleaseLineCharacterIndex(int lineCharacterIndex) {
+	lv.ReleaseLineCharacterIndex(lineCharacterIndex);
+}
+
+/// Only meaningful for an allocated index; line may be Lines() for the total count.
+int CellBuffer::IndexLineStart(int line, int lineCharacterIndex) const {
+	if (line < 0)
+		return 0;
+	if (line > Lines())
+		line = Lines();
+	return lv.IndexLineStart(line, lineCharacterIndex);
+}
+
+int CellBuffer::LineFromPositionIndex(int pos, int lineCharacterIndex) const {
+	return lv.LineFromPositionIndex(pos, lineCharacterIndex);
+}
+
+// Width in bytes of the character at position, stepping over invalid bytes one at a
+// time in the same way as Document::NextPosition.
+int CellBuffer::UTF8WidthAt(int position) const {
+	const unsigned char leadByte = substance.ValueAt(position);
+	if (UTF8IsAscii(leadByte))
+		return 1;
+	const int widthCharBytes = UTF8BytesOfLead[leadByte];
+	unsigned char charBytes[UTF8MaxBytes] = {leadByte, 0, 0, 0};
+	for (int b = 1; b < widthCharBytes; b++)
+		charBytes[b] = substance.ValueAt(position + b);
+	const int utf8status = UTF8Classify(charBytes, widthCharBytes);
+	if (utf8status & UTF8MaskInvalid)
+		return 1;
+	return utf8status & UTF8MaskWidth;
+}
+
+// Whether inserting or deleting s just before positionAfter only changes the character
+// count of its line by length: the text is ASCII without line ends and does not touch
+// the trail bytes of a multi-byte character. The caller also checks the line count.
+bool CellBuffer::SimpleCharacterChange(const char *s, int length, int positionAfter) const {
+	for (int i = 0; i < length; i++) {
+		const unsigned char ch = s[i];
+		if ((ch == '\r') || (ch == '\n') || (utf8Substance && !UTF8IsAscii(ch)))
+			return false;
+	}
+	return !utf8Substance || !UTF8IsTrailByte(static_cast<unsigned char>(substance.ValueAt(positionAfter)));
+}
+
+// Measure lines whose text changed and store their widths in the line character index.
+void CellBuffer::RecalculateIndexLineStarts(int lineFirst, int lineLast) {
+	if (!lv.LineCharacterIndex())
+		return;
+	int position = LineStart(lineFirst);
+	for (int line = lineFirst; line <= lineLast; line++) {
+		const int positionEnd = LineStart(line + 1);
+		int widthUTF32 = positionEnd - position;
+		int widthUTF16 = widthUTF32;
+		if (utf8Substance) {
+			widthUTF32 = 0;
+			widthUTF16 = 0;
+			while (position < positionEnd) {
+				const int widthBytes = UTF8WidthAt(position);
+				widthUTF32++;
+				widthUTF16 += (widthBytes > 3) ? 2 : 1;
+				position += widthBytes;
+			}
+		}
+		lv.SetLineCharactersWidth(line, widthUTF32, widthUTF16);
+		position = positionEnd;
+	}
+}
+
 bool CellBuffer::UTF8LineEndOverlaps(int position) const {
 	unsigned char bytes[] = {
 		static_cast<unsigned char>(substance.ValueAt(position-2)),
@@ -618,6 +906,7 @@ void CellBuffer::ResetLineEnds() {
 		chBeforePrev = chPrev;
 		chPrev = ch;
 	}
+	RecalculateIndexLineStarts(0, Lines() - 1);
 }
 
 void CellBuffer::BasicInsertString(int position, const char *s, int insertLength) {
@@ -625,6 +914,10 @@ void CellBuffer::BasicInsertString(int position, const char *s, int insertLength
 		return;
 	PLATFORM_ASSERT(insertLength > 0);
 
+	const int lineChanged = lv.LineFromPosition(position);
+	const int linesBefore = lv.Lines();
+	const bool simpleChange = lv.LineCharacterIndex() && SimpleCharacterChange(s, insertLength, position);
+
 	unsigned char chAfter = substance.ValueAt(position);
 	bool breakingUTF8LineEnd = false;
 	if (utf8LineEnds && UTF8IsTrailByte(chAfter)) {
@@ -695,12 +988,25 @@ void CellBuffer::BasicInsertString(int position, const char *s, int insertLength
 			chPrev = chAt;
 		}
 	}
+
+	if (lv.LineCharacterIndex()) {
+		if (simpleChange && (lv.Lines() == linesBefore)) {
+			lv.InsertCharacters(lineChanged, insertLength, insertLength);
+		} else {
+			RecalculateIndexLineStarts(std::min(lineChanged, lv.LineFromPosition(position)),
+				lv.LineFromPosition(position + insertLength));
+		}
+	}
 }
 
 void CellBuffer::BasicDeleteChars(int position, int deleteLength) {
 	if (deleteLength == 0)
 		return;
 
+	const int lineChanged = lv.LineFromPosition(position);
+	const int linesBefore = lv.Lines();
+	bool simpleChange = false;
+
 	if ((position == 0) && (deleteLength == substance.Length())) {
 		// If whole buffer is being deleted, faster to reinitialise lines data
 		// than to delete each line.
@@ -709,6 +1015,9 @@ void CellBuffer::BasicDeleteChars(int position, int deleteLength) {
 		// Have to fix up line positions before doing deletion as looking at text in buffer
 		// to work out which lines have been removed
 
+		simpleChange = lv.LineCharacterIndex() &&
+			SimpleCharacterChange(substance.RangePointer(position, deleteLength), deleteLength, position + deleteLength);
+
 		int lineRemove = lv.LineFromPosition(position) + 1;
 		lv.InsertText(lineRemove-1, - (deleteLength));
 		unsigned char chPrev = substance.ValueAt(position - 1);
@@ -763,6 +1072,15 @@ void CellBuffer::BasicDeleteChars(int position, int deleteLength) {
 	}
 	substance.DeleteRange(position, deleteLength);
 	style.DeleteRange(position, deleteLength);
+
+	if (lv.LineCharacterIndex()) {
+		if (simpleChange && (lv.Lines() == linesBefore)) {
+			lv.InsertCharacters(lineChanged, -deleteLength, -deleteLength);
+		} else {
+			const int lineAfter = lv.LineFromPosition(position);
+			RecalculateIndexLineStarts(std::min(lineChanged, lineAfter), lineAfter);
+		}
+	}
 }
 
 bool CellBuffer::SetUndoCollection(bool collectUndo) {
@@ -792,6 +1110,18 @@ void CellBuffer::DeleteUndoHistory() {
 	uh.DeleteUndoHistory();
 }
 
+void CellBuffer::SetUndoMemoryLimit(size_t limit) {
+	uh.SetMemoryLimit(limit);
+}
+
+size_t CellBuffer::UndoMemoryLimit() const {
+	return uh.MemoryLimit();
+}
+
+size_t CellBuffer::UndoMemoryUsage() const {
+	return uh.MemoryUsage();
+}
+
 bool CellBuffer::CanUndo() const {
 	return uh.CanUndo();
 }
@@ -21,6 +21,22 @@ public:
 	virtual void RemoveLine(int line)=0;
 };
 
+/**
+ * Number of characters or UTF-16 code units before the start of each line.
+ * Only maintained while some client has allocated it.
+ */
+class LineStartIndex {
+public:
+	int refCount;
+	Partitioning starts;
+
+	LineStartIndex() : refCount(0), starts(256) {}
+	bool Active() const {
+		return refCount > 0;
+	}
+	void SetLineWidth(int line, int width);
+};
+
 /**
  * The line vector contains information about each of the lines in a cell buffer.
  */
@@ -28,6 +44,8 @@ class LineVector {
 
 	Partitioning starts;
 	PerLine *perLine;
+	LineStartIndex startsUTF32;
+	LineStartIndex startsUTF16;
 
 public:
 
@@ -47,10 +65,55 @@ public:
 	int LineStart(int line) const {
 		return starts.PositionFromPartition(line);
 	}
+
+	int LineCharacterIndex() const;
+	bool AllocateLineCharacterIndex(int lineCharacterIndex);
+	void ReleaseLineCharacterIndex(int lineCharacterIndex);
+	void SetLineCharactersWidth(int line, int widthUTF32, int widthUTF16);
+	void InsertCharacters(int line, int deltaUTF32, int deltaUTF16);
+	int IndexLineStart(int line, int lineCharacterIndex) const;
+	int LineFromPositionIndex(int pos, int lineCharacterIndex) const;
 };
 
 enum actionType { insertAction, removeAction, startAction, containerAction };
 
+/// A position in an UndoLog
+struct UndoLogPosition {
+	int chunk;
+	int offset;
+	UndoLogPosition() : chunk(0), offset(0) {}
+};
+
+/**
+ * Append-only storage for the text of undo actions.
+ * Text is stored in large chunks so that it never moves and doesn't need an allocation
+ * per action. As text is appended in the order of the actions, dropping the newest actions
+ * just moves the end back and dropping the oldest ones frees whole chunks.
+ */
+class UndoLog {
+	struct Chunk {
+		char *text;
+		int size;
+		int used;
+	};
+	std::vector<Chunk> chunks;
+	size_t allocated;
+
+	// Private so UndoLog objects can not be copied
+	UndoLog(const UndoLog &);
+
+public:
+	UndoLog();
+	~UndoLog();
+
+	const char *Append(const char *s, int length);
+	UndoLogPosition End() const;
+	void Truncate(UndoLogPosition end);
+	int Chunks() const { return static_cast<int>(chunks.size()); }
+	void DropFirstChunk();
+	size_t MemoryUsage() const { return allocated; }
+};
+
 /**
  * Actions are used to store all the information required to perform one undo/redo step.
  */
@@ -58,14 +121,13 @@ class Action {
 public:
 	actionType at;
 	int position;
-	char *data;
+	const char *data;	// Stored in the UndoLog of the history
 	int lenData;
 	bool mayCoalesce;
+	UndoLogPosition logEnd;	// End of the UndoLog after the data of this action
 
 	Action();
-	~Action();
 	void Create(actionType at_, int position_=0, const char *data_=0, int lenData_=0, bool mayCoalesce_=true);
-	void Destroy();
 	void Grab(Action *source);
 };
 
@@ -80,8 +142,13 @@ class UndoHistory {
 	int undoSequenceDepth;
 	int savePoint;
 	int tentativePoint;
+	UndoLog log;
+	size_t memoryLimit;
 
 	void EnsureUndoRoom();
+	void CreateAction(int act, actionType at, int position=0, const char *data=0, int lenData=0, bool mayCoalesce=true);
+	bool DropOldestActions();
+	void TrimHistory();
 
 	// Private so UndoHistory objects can not be copied
 	UndoHistory(const UndoHistory &);
@@ -118,6 +185,13 @@ public:
 	int StartRedo();
 	const Action &GetRedoStep() const;
 	void CompletedRedoStep();
+
+	/// When the memory used by the history (as returned by MemoryUsage: the stored
+	/// text plus the actions in use) exceeds the limit the oldest actions are dropped.
+	/// 0 means no limit.
+	void SetMemoryLimit(size_t limit);
+	size_t MemoryLimit() const { return memoryLimit; }
+	size_t MemoryUsage() const;
 };
 
 /**
@@ -131,6 +205,7 @@ private:
 	SplitVector<char> style;
 	bool readOnly;
 	int utf8LineEnds;
+	bool utf8Substance;
 
 	bool collectingUndo;
 	UndoHistory uh;
@@ -139,6 +214,9 @@ private:
 
 	bool UTF8LineEndOverlaps(int position) const;
 	void ResetLineEnds();
+	int UTF8WidthAt(int position) const;
+	bool SimpleCharacterChange(const char *s, int length, int positionAfter) const;
+	void RecalculateIndexLineStarts(int lineFirst, int lineLast);
 	/// Actions without undo
 	void BasicInsertString(int position, const char *s, int insertLength);
 	void BasicDeleteChars(int position, int deleteLength);
@@ -156,11 +234,13 @@ public:
 	const char *BufferPointer();
 	const char *RangePointer(int position, int rangeLength);
 	int GapPosition() const;
+	const char *ContiguousRangePointer(int position, int &rangeLength) const;
 
 	int Length() const;
 	void Allocate(int newSize);
 	int GetLineEndTypes() const { return utf8LineEnds; }
 	void SetLineEndTypes(int utf8LineEnds_);
+	void SetUTF8Substance(bool utf8Substance_);
 	bool ContainsLineEnd(const char *s, int length) const;
 	void SetPerLine(PerLine *pl);
 	int Lines() const;
@@ -168,6 +248,11 @@ public:
 	int LineFromPosition(int pos) const { return lv.LineFromPosition(pos); }
 	void InsertLine(int line, int position, bool lineStart);
 	void RemoveLine(int line);
+	int LineCharacterIndex() const;
+	void AllocateLineCharacterIndex(int lineCharacterIndex);
+	void ReleaseLineCharacterIndex(int lineCharacterIndex);
+	int IndexLineStart(int line, int lineCharacterIndex) const;
+	int LineFromPositionIndex(int pos, int lineCharacterIndex) const;
 	const char *InsertString(int position, const char *s, int insertLength, bool &startSequence);
 
 	/// Setting styles for positions outside the range of the buffer is safe and has no effect.
@@ -196,6 +281,9 @@ public:
 	void EndUndoAction();
 	void AddUndoAction(int token, bool mayCoalesce);
 	void DeleteUndoHistory();
+	void SetUndoMemoryLimit(size_t limit);
+	size_t UndoMemoryLimit() const;
+	size_t UndoMemoryUsage() const;
 
 	/// To perform an undo, StartUndo is called to retrieve the number of steps, then UndoStep is
 	/// called that many times. Similarly for redo.
@@ -104,6 +104,9 @@ Document::Document() {
 	lineEndBitSet = SC_LINE_END_TYPE_DEFAULT;
 	endStyled = 0;
 	styleClock = 0;
+	endStyledPrior = 0;
+	endModifiedPrior = 0;
+	stylingConvergence = false;
 	enteredModification = 0;
 	enteredStyling = 0;
 	enteredReadOnlyCount = 0;
@@ -166,6 +169,7 @@ bool Document::SetDBCSCodePage(int dbcsCodePage_) {
 	if (dbcsCodePage != dbcsCodePage_) {
 		dbcsCodePage = dbcsCodePage_;
 		SetCaseFolder(NULL);
+		cb.SetUTF8Substance(SC_CP_UTF8 == dbcsCodePage);
 		cb.SetLineEndTypes(lineEndBitSet & LineEndTypesSupported());
 		return true;
 	} else {
@@ -249,7 +253,7 @@ void Document::TentativeUndo() {
 				}
 				cb.PerformUndoStep();
 				if (action.at != containerAction) {
-					ModifiedAt(action.position);
+					TextModifiedAt(action.position);
 				}
 
 				int modFlags = SC_PERFORMED_UNDO;
@@ -435,6 +439,7 @@ int SCI_METHOD Document::GetLevel(Sci_Position line) const {
 
 void Document::ClearLevels() {
 	static_cast<LineLevels *>(perLineData[ldLevels])->ClearLevels();
+	endStyledPrior = 0;
 }
 
 static bool IsSubordinate(int levelStart, int levelTry) {
@@ -851,6 +856,9 @@ Document::CharacterExtracted Document::CharacterBefore(int position) const {
 Sci_Position SCI_METHOD Document::GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const {
 	int pos = positionStart;
 	if (dbcsCodePage) {
+		if ((LineCharacterIndex() & SC_LINECHARACTERINDEX_UTF32) && LeavesLine(pos, characterOffset))
+			return PositionFromIndex(IndexFromPosition(pos, SC_LINECHARACTERINDEX_UTF32) + characterOffset,
+				SC_LINECHARACTERINDEX_UTF32);
 		const int increment = (characterOffset > 0) ? 1 : -1;
 		while (characterOffset != 0) {
 			const int posNext = NextPosition(pos, increment);
@@ -870,6 +878,9 @@ Sci_Position SCI_METHOD Document::GetRelativePosition(Sci_Position positionStart
 int Document::GetRelativePositionUTF16(int positionStart, int characterOffset) const {
 	int pos = positionStart;
 	if (dbcsCodePage) {
+		if ((LineCharacterIndex() & SC_LINECHARACTERINDEX_UTF16) && LeavesLine(pos, characterOffset))
+			return PositionFromIndex(IndexFromPosition(pos, SC_LINECHARACTERINDEX_UTF16) + characterOffset,
+				SC_LINECHARACTERINDEX_UTF16);
 		const int increment = (characterOffset > 0) ? 1 : -1;
 		while (characterOffset != 0) {
 			const int posNext = NextPosition(pos, increment);
@@ -888,6 +899,81 @@ int Document::GetRelativePositionUTF16(int positionStart, int characterOffset) c
 	return pos;
 }
 
+int Document::LineCharacterIndex() const {
+	if (SC_CP_UTF8 == dbcsCodePage)
+		return cb.LineCharacterIndex();
+	return SC_LINECHARACTERINDEX_NONE;
+}
+
+void Document::AllocateLineCharacterIndex(int lineCharacterIndex) {
+	cb.AllocateLineCharacterIndex(lineCharacterIndex);
+}
+
+void Document::ReleaseLineCharacterIndex(int lineCharacterIndex) {
+	cb.ReleaseLineCharacterIndex(lineCharacterIndex);
+}
+
+int Document::IndexLineStart(int line, int lineCharacterIndex) const {
+	if (LineCharacterIndex() & lineCharacterIndex)
+		return cb.IndexLineStart(line, lineCharacterIndex);
+	// No index so count from the start of the document
+	const int position = LineStart(line);
+	if (lineCharacterIndex == SC_LINECHARACTERINDEX_UTF16)
+		return CountUTF16(0, position);
+	return CountCharacters(0, position);
+}
+
+int Document::LineFromIndexPosition(int pos, int lineCharacterIndex) const {
+	if (LineCharacterIndex() & lineCharacterIndex)
+		return cb.LineFromPositionIndex(pos, lineCharacterIndex);
+	const int position = (lineCharacterIndex == SC_LINECHARACTERINDEX_UTF16) ?
+		GetRelativePositionUTF16(0, pos) : static_cast<int>(GetRelativePosition(0, pos));
+	if (position == INVALID_POSITION)
+		return (pos <= 0) ? 0 : LinesTotal() - 1;
+	return static_cast<int>(LineFromPosition(position));
+}
+
+// Whether moving by characterOffset from the character boundary pos is sure to reach
+// another line, as every character takes at least one byte.
+bool Document::LeavesLine(int pos, int characterOffset) const {
+	if (pos != MovePositionOutsideChar(pos, 1, false))
+		return false;
+	const int line = static_cast<int>(LineFromPosition(pos));
+	if (characterOffset > 0)
+		return characterOffset > LineStart(line + 1) - pos;
+	else
+		return -characterOffset > pos - LineStart(line);
+}
+
+// Number of characters or UTF-16 code units before the character boundary pos.
+int Document::IndexFromPosition(int pos, int lineCharacterIndex) const {
+	const int line = static_cast<int>(LineFromPosition(pos));
+	const int lineStart = LineStart(line);
+	const int inLine = (lineCharacterIndex == SC_LINECHARACTERINDEX_UTF16) ?
+		CountUTF16(lineStart, pos) : CountCharacters(lineStart, pos);
+	return cb.IndexLineStart(line, lineCharacterIndex) + inLine;
+}
+
+// Position of the character index units from the document start, found through the
+// line index and then by stepping within the line.
+int Document::PositionFromIndex(int index, int lineCharacterIndex) const {
+	if ((index < 0) || (index > cb.IndexLineStart(LinesTotal(), lineCharacterIndex)))
+		return INVALID_POSITION;
+	const int line = cb.LineFromPositionIndex(index, lineCharacterIndex);
+	int pos = LineStart(line);
+	int remaining = index - cb.IndexLineStart(line, lineCharacterIndex);
+	while (remaining > 0) {
+		const int posNext = NextPosition(pos, 1);
+		if ((lineCharacterIndex == SC_LINECHARACTERINDEX_UTF16) && ((posNext - pos) > 3))
+			remaining--;	// 4 byte character = 2*UTF16.
+		remaining--;
+		pos = posNext;
+	}
+	if (remaining < 0)	// Inside a surrogate pair
+		return INVALID_POSITION;
+	return pos;
+}
+
 int SCI_METHOD Document::GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const {
 	int character;
 	int bytesInCharacter = 1;
@@ -1021,6 +1107,21 @@ EncodingFamily Document::CodePageFamily() const {
 void Document::ModifiedAt(int pos) {
 	if (endStyled > pos)
 		endStyled = pos;
+	// Styling is invalidated for some other reason than a text change, so the old
+	// styles can not be kept
+	endStyledPrior = 0;
+}
+
+// The text changed at pos. NotifyModified() then adjusts the region of styles left from
+// before the change.
+void Document::TextModifiedAt(int pos) {
+	if (endStyled > pos) {
+		if (endStyledPrior < endStyled) {
+			endStyledPrior = endStyled;
+			endModifiedPrior = 0;
+		}
+		endStyled = pos;
+	}
 }
 
 void Document::CheckReadOnly() {
@@ -1059,9 +1160,9 @@ bool Document::DeleteChars(int pos, int len) {
 			if (startSavePoint && cb.IsCollectingUndo())
 				NotifySavePoint(!startSavePoint);
 			if ((pos < Length()) || (pos == 0))
-				ModifiedAt(pos);
+				TextModifiedAt(pos);
 			else
-				ModifiedAt(pos-1);
+				TextModifiedAt(pos-1);
 			NotifyModified(
 			    DocModification(
 			        SC_MOD_DELETETEXT | SC_PERFORMED_USER | (startSequence?SC_STARTACTION:0),
@@ -1110,7 +1211,7 @@ int Document::InsertString(int position, const char *s, int insertLength) {
 	const char *text = cb.InsertString(position, s, insertLength, startSequence);
 	if (startSavePoint && cb.IsCollectingUndo())
 		NotifySavePoint(!startSavePoint);
-	ModifiedAt(position);
+	TextModifiedAt(position);
 	NotifyModified(
 		DocModification(
 			SC_MOD_INSERTTEXT | SC_PERFORMED_USER | (startSequence?SC_STARTACTION:0),
@@ -1180,7 +1281,7 @@ int Document::Undo() {
 				}
 				cb.PerformUndoStep();
 				if (action.at != containerAction) {
-					ModifiedAt(action.position);
+					TextModifiedAt(action.position);
 					newPos = action.position;
 				}
 
@@ -1254,7 +1355,7 @@ int Document::Redo() {
 				}
 				cb.PerformRedoStep();
 				if (action.at != containerAction) {
-					ModifiedAt(action.position);
+					TextModifiedAt(action.position);
 					newPos = action.position;
 				}
 
@@ -1398,6 +1499,11 @@ int Document::GetColumn(int pos) {
 int Document::CountCharacters(int startPos, int endPos) const {
 	startPos = MovePositionOutsideChar(startPos, 1, false);
 	endPos = MovePositionOutsideChar(endPos, -1, false);
+	if ((endPos > startPos) && (LineCharacterIndex() & SC_LINECHARACTERINDEX_UTF32) &&
+		(LineFromPosition(startPos) != LineFromPosition(endPos))) {
+		return IndexFromPosition(endPos, SC_LINECHARACTERINDEX_UTF32) -
+			IndexFromPosition(startPos, SC_LINECHARACTERINDEX_UTF32);
+	}
 	int count = 0;
 	int i = startPos;
 	while (i < endPos) {
@@ -1410,6 +1516,11 @@ int Document::CountCharacters(int startPos, int endPos) const {
 int Document::CountUTF16(int startPos, int endPos) const {
 	startPos = MovePositionOutsideChar(startPos, 1, false);
 	endPos = MovePositionOutsideChar(endPos, -1, false);
+	if ((endPos > startPos) && (LineCharacterIndex() & SC_LINECHARACTERINDEX_UTF16) &&
+		(LineFromPosition(startPos) != LineFromPosition(endPos))) {
+		return IndexFromPosition(endPos, SC_LINECHARACTERINDEX_UTF16) -
+			IndexFromPosition(startPos, SC_LINECHARACTERINDEX_UTF16);
+	}
 	int count = 0;
 	int i = startPos;
 	while (i < endPos) {
@@ -1833,6 +1944,41 @@ Document::CharacterExtracted Document::ExtractCharacter(int position) const {
 	}
 }
 
+// Find the first position in [pos, end) holding ch or return end.
+// The parts of the buffer before and after the gap are scanned with memchr without
+// moving the gap or checking it on every byte.
+int Document::FindByte(int pos, int end, char ch) const {
+	while (pos < end) {
+		int lengthContiguous = 0;
+		const char *text = cb.ContiguousRangePointer(pos, lengthContiguous);
+		const int lengthScan = Platform::Minimum(lengthContiguous, end - pos);
+		if (lengthScan <= 0)
+			break;
+		const void *found = memchr(text, static_cast<unsigned char>(ch), lengthScan);
+		if (found)
+			return pos + static_cast<int>(static_cast<const char *>(found) - text);
+		pos += lengthScan;
+	}
+	return end;
+}
+
+// Find the first position in [pos, end) holding a byte for which inSet is true or return end.
+int Document::FindByteInSet(int pos, int end, const bool *inSet) const {
+	while (pos < end) {
+		int lengthContiguous = 0;
+		const char *text = cb.ContiguousRangePointer(pos, lengthContiguous);
+		const int lengthScan = Platform::Minimum(lengthContiguous, end - pos);
+		if (lengthScan <= 0)
+			break;
+		for (int i = 0; i < lengthScan; i++) {
+			if (inSet[static_cast<unsigned char>(text[i])])
+				return pos + i;
+		}
+		pos += lengthScan;
+	}
+	return end;
+}
+
 /**
  * Find text in document, supporting both forward and backward
  * searches (just pass minPos > maxPos to do a backward search)
@@ -1872,7 +2018,16 @@ long Document::FindText(int minPos, int maxPos, const char *search,
 		if (caseSensitive) {
 			const int endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
 			const char charStartSearch =  search[0];
+			// The first byte of search can only be found inside a character when it is a
+			// UTF-8 trail byte or in DBCS so otherwise jump straight to its occurrences
+			const bool scanBytes = forward && (!dbcsCodePage || ((SC_CP_UTF8 == dbcsCodePage) &&
+				!UTF8IsTrailByte(static_cast<unsigned char>(charStartSearch))));
 			while (forward ? (pos < endSearch) : (pos >= endSearch)) {
+				if (scanBytes) {
+					pos = FindByte(pos, endSearch, charStartSearch);
+					if (pos >= endSearch)
+						break;
+				}
 				if (CharAt(pos) == charStartSearch) {
 					bool found = (pos + lengthFind) <= limitPos;
 					for (int indexSearch = 1; (indexSearch < lengthFind) && found; indexSearch++) {
@@ -1892,7 +2047,23 @@ long Document::FindText(int minPos, int maxPos, const char *search,
 				pcf->Fold(&searchThing[0], searchThing.size(), search, lengthFind));
 			char bytes[UTF8MaxBytes + 1];
 			char folded[UTF8MaxBytes * maxFoldingExpansion + 1];
+			// ASCII characters fold to a single ASCII byte so when searching forward skip
+			// over those which can't start a match, other characters are checked fully
+			bool startsMatch[256];
+			for (int b = 0; b < 256; b++) {
+				startsMatch[b] = true;
+				if (UTF8IsAscii(b)) {
+					const char ch = static_cast<char>(b);
+					pcf->Fold(folded, sizeof(folded), &ch, 1);
+					startsMatch[b] = folded[0] == searchThing[0];
+				}
+			}
 			while (forward ? (pos < endPos) : (pos >= endPos)) {
+				if (forward) {
+					pos = FindByteInSet(pos, endPos, startsMatch);
+					if (pos >= endPos)
+						break;
+				}
 				int widthFirstCharacter = 0;
 				int posIndexDocument = pos;
 				int indexSearch = 0;
@@ -1977,13 +2148,26 @@ long Document::FindText(int minPos, int maxPos, const char *search,
 			const int endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
 			std::vector<char> searchThing(lengthFind + 1);
 			pcf->Fold(&searchThing[0], searchThing.size(), search, lengthFind);
+			// Fold every byte value once instead of every byte of the document
+			char foldedBytes[256];
+			bool startsMatch[256];
+			for (int b = 0; b < 256; b++) {
+				const char ch = static_cast<char>(b);
+				char folded[2];
+				pcf->Fold(folded, sizeof(folded), &ch, 1);
+				foldedBytes[b] = folded[0];
+				startsMatch[b] = folded[0] == searchThing[0];
+			}
 			while (forward ? (pos < endSearch) : (pos >= endSearch)) {
+				if (forward) {
+					pos = FindByteInSet(pos, endSearch, startsMatch);
+					if (pos >= endSearch)
+						break;
+				}
 				bool found = (pos + lengthFind) <= limitPos;
 				for (int indexSearch = 0; (indexSearch < lengthFind) && found; indexSearch++) {
-					char ch = CharAt(pos + indexSearch);
-					char folded[2];
-					pcf->Fold(folded, sizeof(folded), &ch, 1);
-					found = folded[0] == searchThing[indexSearch];
+					found = foldedBytes[static_cast<unsigned char>(CharAt(pos + indexSearch))] ==
+						searchThing[indexSearch];
 				}
 				if (found && MatchesWordOptions(word, wordStart, pos, lengthFind)) {
 					return pos;
@@ -2075,7 +2259,10 @@ void Document::EnsureStyledTo(int pos) {
 		if (pli && !pli->UseContainerLexing()) {
 			int lineEndStyled = LineFromPosition(GetEndStyled());
 			int endStyledTo = LineStart(lineEndStyled);
-			pli->Colourise(endStyledTo, pos);
+			if (stylingConvergence && (endStyledPrior > GetEndStyled()))
+				ColouriseConverging(endStyledTo, pos);
+			else
+				pli->Colourise(endStyledTo, pos);
 		} else {
 			// Ask the watchers to style, and stop as soon as one responds.
 			for (std::vector<WatcherWithUserData>::iterator it = watchers.begin();
@@ -2086,6 +2273,54 @@ void Document::EnsureStyledTo(int pos) {
 	}
 }
 
+// After a modification, lexing usually reaches a line where it is in the same state as it
+// was there before the modification: the same style at the end of the line, line state and
+// fold level. From there on the styling left from before the modification is still right,
+// so it is kept instead of styling the rest of the document again.
+// This relies on lexers keeping all that is needed to continue from a line start in
+// these, which applications confirm with SCI_SETSTYLINGCONVERGENCE. Lexers may still
+// carry something in a style, such as a here document delimiter, so only lines ending
+// in the default style 0 are compared.
+void Document::ColouriseConverging(int start, int end) {
+	int lineCheck = LineFromPosition(endModifiedPrior) + 1;
+	int linesChunk = 16;
+	while (start < end) {
+		const int posCheck = LineStart(lineCheck);
+		if ((lineCheck >= LinesTotal()) || (posCheck > end) || (posCheck >= endStyledPrior) ||
+			(posCheck <= start)) {
+			pli->Colourise(start, end);
+			return;
+		}
+
+		const int lineLast = lineCheck - 1;
+		const int stylePrior = StyleAt(posCheck - 1);
+		const int statePrior = GetLineState(lineLast);
+		const int stateNextPrior = GetLineState(lineCheck);
+		const int levelPrior = GetLevel(lineLast);
+		const int levelNextPrior = GetLevel(lineCheck);
+
+		pli->Colourise(start, posCheck);
+		if (GetEndStyled() != posCheck) {
+			// The lexer did not stop at the line start so check no further
+			if (GetEndStyled() < end)
+				pli->Colourise(LineStart(LineFromPosition(GetEndStyled())), end);
+			return;
+		}
+		if ((stylePrior == 0) && (StyleAt(posCheck - 1) == stylePrior) &&
+			(GetLineState(lineLast) == statePrior) && (GetLineState(lineCheck) == stateNextPrior) &&
+			(GetLevel(lineLast) == levelPrior) && (GetLevel(lineCheck) == levelNextPrior)) {
+			endStyled = std::min(endStyledPrior, Length());
+			endStyledPrior = 0;
+			return;
+		}
+
+		start = posCheck;
+		lineCheck += linesChunk;
+		if (linesChunk < 4096)
+			linesChunk *= 2;
+	}
+}
+
 void Document::StyleToAdjustingLineDuration(int pos) {
 	// Place bounds on the duration used to avoid glitches spiking it
 	// and so causing slow styling or non-responsive scrolling
@@ -2263,6 +2498,23 @@ void Document::NotifyModified(DocModification mh) {
 	} else if (mh.modificationType & SC_MOD_DELETETEXT) {
 		decorations.DeleteRange(mh.position, mh.length);
 	}
+	if (mh.modificationType & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT | SC_MOD_CHANGESTYLE)) {
+		braceIndex.Truncate(mh.position);
+	}
+	if ((mh.modificationType & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT)) && (endStyledPrior > mh.position)) {
+		// Move the old styles along with the text and widen the modified range
+		if (mh.modificationType & SC_MOD_INSERTTEXT) {
+			endStyledPrior += mh.length;
+			if (endModifiedPrior > mh.position)
+				endModifiedPrior += mh.length;
+			endModifiedPrior = std::max(endModifiedPrior, mh.position + mh.length);
+		} else {
+			endStyledPrior = std::max(endStyledPrior - mh.length, mh.position);
+			if (endModifiedPrior > mh.position)
+				endModifiedPrior = std::max(endModifiedPrior - mh.length, mh.position);
+			endModifiedPrior = std::max(endModifiedPrior, mh.position);
+		}
+	}
 	for (std::vector<WatcherWithUserData>::iterator it = watchers.begin(); it != watchers.end(); ++it) {
 		it->watcher->NotifyModified(this, mh, it->userData);
 	}
@@ -2443,6 +2695,137 @@ static char BraceOpposite(char ch) {
 	}
 }
 
+// Opening and closing braces of each kind
+static const char braceChars[] = "()[]{}<>";
+
+namespace {
+
+struct BraceSet {
+	bool inSet[256];
+	BraceSet() {
+		std::fill(inSet, inSet + 256, false);
+		for (const char *brace = braceChars; *brace; brace++)
+			inSet[static_cast<unsigned char>(*brace)] = true;
+	}
+};
+
+const BraceSet braceSet;
+
+// Most braces match a brace close by, so the text is scanned for this many characters
+// before using the index
+const int braceScanSteps = 0x4000;
+const int braceScanStopped = -2;
+
+// Number of bytes indexed at a time when looking for the brace matching an opening brace
+const int braceIndexBlockSize = 0x10000;
+
+}
+
+BraceIndex::BraceIndex() : end(0), codePage(0) {
+}
+
+void BraceIndex::Reset(int codePage_) {
+	braces.clear();
+	openBraces.clear();
+	end = 0;
+	codePage = codePage_;
+}
+
+// Text or styles changed at position so forget the braces from there on. This takes time
+// proportional to the number of braces removed, which all had to be added before.
+void BraceIndex::Truncate(int position) {
+	if (position >= end)
+		return;
+	const int length = LowerBound(position);
+	std::vector<int> reopened;
+	for (size_t i = length; i < braces.size(); i++) {
+		const Brace &brace = braces[i];
+		if (brace.opening) {
+			std::vector<int> &open = openBraces[brace.key];
+			while (!open.empty() && open.back() >= length)
+				open.pop_back();
+		} else if (brace.match >= 0 && brace.match < length) {
+			reopened.push_back(brace.match);
+		}
+	}
+	braces.resize(length);
+	end = position;
+
+	// Opening braces matched by removed braces are unmatched again
+	std::sort(reopened.begin(), reopened.end());
+	for (std::vector<int>::const_iterator it = reopened.begin(); it != reopened.end(); ++it) {
+		std::vector<int> &open = openBraces[braces[*it].key];
+		braces[*it].match = -1;
+		open.insert(std::upper_bound(open.begin(), open.end(), *it), *it);
+	}
+}
+
+int BraceIndex::LowerBound(int position) const {
+	size_t lower = 0;
+	size_t upper = braces.size();
+	while (lower < upper) {
+		const size_t middle = lower + (upper - lower) / 2;
+		if (braces[middle].position < position)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+	return static_cast<int>(lower);
+}
+
+void BraceIndex::Add(int position, char ch, int style) {
+	const int kind = static_cast<int>(strchr(braceChars, ch) - braceChars);
+	Brace brace;
+	brace.position = position;
+	brace.match = -1;
+	brace.key = static_cast<unsigned short>(style * 4 + kind / 2);
+	brace.opening = (kind % 2) == 0;
+
+	if (openBraces.size() <= brace.key)
+		openBraces.resize(brace.key + 1);
+	std::vector<int> &open = openBraces[brace.key];
+	const int index = static_cast<int>(braces.size());
+	if (brace.opening) {
+		open.push_back(index);
+	} else if (!open.empty()) {
+		brace.match = open.back();
+		braces[brace.match].match = index;
+		open.pop_back();
+	}
+	braces.push_back(brace);
+}
+
+void BraceIndex::SetEnd(int position) {
+	if (end < position)
+		end = position;
+}
+
+// Index of the brace at position or -1.
+int BraceIndex::Find(int position) const {
+	const int index = LowerBound(position);
+	if (index < static_cast<int>(braces.size()) && braces[index].position == position)
+		return index;
+	return -1;
+}
+
+// Position of the brace matching the one at index or -1 if none before end.
+int BraceIndex::MatchPosition(int index) const {
+	const int match = braces[index].match;
+	return (match >= 0) ? braces[match].position : -1;
+}
+
+// Nesting depth at end inside the unmatched opening brace at index, counting it.
+int BraceIndex::Depth(int index) const {
+	const std::vector<int> &open = openBraces[braces[index].key];
+	return static_cast<int>(open.end() - std::lower_bound(open.begin(), open.end(), index));
+}
+
+void Document::ExtendBraceIndex(int position) {
+	for (int pos = braceIndex.End(); (pos = FindByteInSet(pos, position, braceSet.inSet)) < position; pos++)
+		braceIndex.Add(pos, cb.CharAt(pos), StyleIndexAt(pos));
+	braceIndex.SetEnd(position);
+}
+
 // TODO: should be able to extend styled region to find matching brace
 int Document::BraceMatch(int position, int /*maxReStyle*/) {
 	char chBrace = CharAt(position);
@@ -2453,9 +2836,38 @@ int Document::BraceMatch(int position, int /*maxReStyle*/) {
 	int direction = -1;
 	if (chBrace == '(' || chBrace == '[' || chBrace == '{' || chBrace == '<')
 		direction = 1;
-	int depth = 1;
-	position = NextPosition(position, direction);
+
+	// Braces in unstyled text match braces of any style so only the styled text is indexed.
+	// In DBCS text, trail bytes can look like braces.
+	const int endIndexed = Platform::Minimum(GetEndStyled() + 1, Length());
+	const bool indexed = (dbcsCodePage == 0 || dbcsCodePage == SC_CP_UTF8) && position < endIndexed;
+	const int match = BraceMatchScan(NextPosition(position, direction), chBrace, styBrace,
+		direction, 1, indexed ? braceScanSteps : -1);
+	if (match != braceScanStopped)
+		return match;
+
+	if (braceIndex.CodePage() != dbcsCodePage)
+		braceIndex.Reset(dbcsCodePage);
+	braceIndex.Truncate(endIndexed);
+	ExtendBraceIndex(Platform::Maximum(braceIndex.End(), position + 1));
+	const int index = braceIndex.Find(position);
+	if (!braceIndex.IsOpening(index))
+		return braceIndex.MatchPosition(index);
+	while (braceIndex.MatchPosition(index) < 0 && braceIndex.End() < endIndexed)
+		ExtendBraceIndex(Platform::Minimum(braceIndex.End() + braceIndexBlockSize, endIndexed));
+	if (braceIndex.MatchPosition(index) >= 0)
+		return braceIndex.MatchPosition(index);
+	// Continue after the indexed text, where braces of any style match
+	return BraceMatchScan(endIndexed, chBrace, styBrace, direction, braceIndex.Depth(index), -1);
+}
+
+// Scan from position for the brace matching chBrace, inside depth nested braces. Gives up
+// with braceScanStopped after maxSteps characters unless maxSteps is -1.
+int Document::BraceMatchScan(int position, char chBrace, int styBrace, int direction, int depth, int maxSteps) {
+	const char chSeek = BraceOpposite(chBrace);
 	while ((position >= 0) && (position < Length())) {
+		if (maxSteps-- == 0)
+			return braceScanStopped;
 		char chAtPos = CharAt(position);
 		const int styAtPos = StyleIndexAt(position);
 		if ((position > GetEndStyled()) || (styAtPos == styBrace)) {
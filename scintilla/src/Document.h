@@ -192,6 +192,38 @@ public:
 	}
 };
 
+/**
+ * The braces in the text of a document before some position, each with the index of the
+ * brace it matches, so that brace matching needs a binary search instead of scanning the
+ * text. Only braces of the same style match, as in Document::BraceMatch.
+ */
+class BraceIndex {
+	struct Brace {
+		int position;
+		int match;	///< Index of the matching brace or -1 if none before end
+		unsigned short key;	///< Style and kind of brace
+		bool opening;
+	};
+	std::vector<Brace> braces;
+	/// Indices of the unmatched opening braces before end for each key
+	std::vector<std::vector<int> > openBraces;
+	int end;
+	int codePage;
+	int LowerBound(int position) const;
+public:
+	BraceIndex();
+	void Reset(int codePage_);
+	void Truncate(int position);
+	int End() const { return end; }
+	int CodePage() const { return codePage; }
+	void Add(int position, char ch, int style);
+	void SetEnd(int position);
+	int Find(int position) const;
+	bool IsOpening(int index) const { return braces[index].opening; }
+	int MatchPosition(int index) const;
+	int Depth(int index) const;
+};
+
 struct RegexError : public std::runtime_error {
 	RegexError() : std::runtime_error("regex failure") {}
 };
@@ -220,6 +252,11 @@ private:
 	CaseFolder *pcf;
 	int endStyled;
 	int styleClock;
+	// Styles, line states and fold levels in [endModifiedPrior, endStyledPrior) are left
+	// from before the latest text modifications, see ColouriseConverging()
+	int endStyledPrior;
+	int endModifiedPrior;
+	bool stylingConvergence;
 	int enteredModification;
 	int enteredStyling;
 	int enteredReadOnlyCount;
@@ -236,6 +273,8 @@ private:
 	bool matchesValid;
 	RegexSearchBase *regex;
 
+	BraceIndex braceIndex;
+
 public:
 
 	struct CharacterExtracted {
@@ -300,6 +339,11 @@ public:
 	Document::CharacterExtracted CharacterBefore(int position) const;
 	Sci_Position SCI_METHOD GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const;
 	int GetRelativePositionUTF16(int positionStart, int characterOffset) const;
+	int LineCharacterIndex() const;
+	void AllocateLineCharacterIndex(int lineCharacterIndex);
+	void ReleaseLineCharacterIndex(int lineCharacterIndex);
+	int IndexLineStart(int line, int lineCharacterIndex) const;
+	int LineFromIndexPosition(int pos, int lineCharacterIndex) const;
 	int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const;
 	int SCI_METHOD CodePage() const;
 	bool SCI_METHOD IsDBCSLeadByte(char ch) const;
@@ -308,6 +352,7 @@ public:
 
 	// Gateways to modifying document
 	void ModifiedAt(int pos);
+	void TextModifiedAt(int pos);
 	void CheckReadOnly();
 	bool DeleteChars(int pos, int len);
 	int InsertString(int position, const char *s, int insertLength);
@@ -319,6 +364,9 @@ public:
 	bool CanUndo() const { return cb.CanUndo(); }
 	bool CanRedo() const { return cb.CanRedo(); }
 	void DeleteUndoHistory() { cb.DeleteUndoHistory(); }
+	void SetUndoMemoryLimit(size_t limit) { cb.SetUndoMemoryLimit(limit); }
+	size_t UndoMemoryLimit() const { return cb.UndoMemoryLimit(); }
+	size_t UndoMemoryUsage() const { return cb.UndoMemoryUsage(); }
 	bool SetUndoCollection(bool collectUndo) {
 		return cb.SetUndoCollection(collectUndo);
 	}
@@ -415,6 +463,8 @@ public:
 	int GetEndStyled() const { return endStyled; }
 	void EnsureStyledTo(int pos);
 	void StyleToAdjustingLineDuration(int pos);
+	void SetStylingConvergence(bool stylingConvergence_) { stylingConvergence = stylingConvergence_; }
+	bool StylingConvergence() const { return stylingConvergence; }
 	void LexerChanged();
 	int GetStyleClock() const { return styleClock; }
 	void IncrementStyleClock();
@@ -457,6 +507,14 @@ public:
 	int BraceMatch(int position, int maxReStyle);
 
 private:
+	int FindByte(int pos, int end, char ch) const;
+	int FindByteInSet(int pos, int end, const bool *inSet) const;
+	void ExtendBraceIndex(int position);
+	int BraceMatchScan(int position, char chBrace, int styBrace, int direction, int depth, int maxSteps);
+	void ColouriseConverging(int start, int end);
+	bool LeavesLine(int pos, int characterOffset) const;
+	int IndexFromPosition(int pos, int lineCharacterIndex) const;
+	int PositionFromIndex(int index, int lineCharacterIndex) const;
 	void NotifyModifyAttempt();
 	void NotifySavePoint(bool atSavePoint);
 	void NotifyModified(DocModification mh);
@@ -184,6 +184,8 @@ Editor::Editor() {
 	recordingMacro = false;
 	foldAutomatic = 0;
 
+	durationWrapOneLine = 0.00001;
+
 	convertPastes = true;
 
 	SetRepresentations();
@@ -1471,10 +1473,32 @@ bool Editor::WrapOneLine(Surface *surface, int lineToWrap) {
 		(vs.annotationVisible ? pdoc->AnnotationLines(lineToWrap) : 0));
 }
 
+void Editor::AdjustWrapLineDuration(int linesWrapped, double durationWrapping) {
+	// Place bounds on the duration used to avoid glitches spiking it
+	// and so causing slow wrapping or non-responsive scrolling
+	const double minDurationOneLine = 0.000001;
+	const double maxDurationOneLine = 0.001;
+
+	// Alpha value for exponential smoothing.
+	// Most recent value contributes 25% to smoothed value.
+	const double alpha = 0.25;
+
+	if (linesWrapped >= 8) {
+		// Only adjust for wrapping multiple lines to avoid instability
+		const double durationOneLine = durationWrapping / linesWrapped;
+		durationWrapOneLine = alpha * durationOneLine + (1.0 - alpha) * durationWrapOneLine;
+		if (durationWrapOneLine < minDurationOneLine) {
+			durationWrapOneLine = minDurationOneLine;
+		} else if (durationWrapOneLine > maxDurationOneLine) {
+			durationWrapOneLine = maxDurationOneLine;
+		}
+	}
+}
+
 // Perform  wrapping for a subset of the lines needing wrapping.
 // wsAll: wrap all lines which need wrapping in this single call
 // wsVisible: wrap currently visible lines
-// wsIdle: wrap one page + 100 lines
+// wsIdle: wrap as many lines as fit in a short time, at least one page + 100 lines
 // Return true if wrapping occurred.
 bool Editor::WrapLines(enum wrapScope ws) {
 	int goodTopLine = topLine;
@@ -1519,7 +1543,13 @@ bool Editor::WrapLines(enum wrapScope ws) {
 				return false;
 			}
 		} else if (ws == wsIdle) {
-			lineToWrapEnd = lineToWrap + LinesOnScreen() + 100;
+			// Try to keep time taken by wrapping reasonable so interaction remains smooth
+			// while not returning to the main loop more often than needed.
+			const double secondsAllowed = 0.02;
+			const int linesInAllowedTime = Platform::Clamp(
+				static_cast<int>(secondsAllowed / durationWrapOneLine),
+				LinesOnScreen() + 100, 0x10000);
+			lineToWrapEnd = lineToWrap + linesInAllowedTime;
 		}
 		const int lineEndNeedWrap = std::min(wrapPending.end, pdoc->LinesTotal());
 		lineToWrapEnd = std::min(lineToWrapEnd, lineEndNeedWrap);
@@ -1538,6 +1568,8 @@ bool Editor::WrapLines(enum wrapScope ws) {
 			if (surface) {
 //Platform::DebugPrintf("Wraplines: scope=%0d need=%0d..%0d perform=%0d..%0d\n", ws, wrapPending.start, wrapPending.end, lineToWrap, lineToWrapEnd);
 
+				const int lineFirst = lineToWrap;
+				ElapsedTime etWrapping;
 				while (lineToWrap < lineToWrapEnd) {
 					if (WrapOneLine(surface, lineToWrap)) {
 						wrapOccurred = true;
@@ -1545,6 +1577,7 @@ bool Editor::WrapLines(enum wrapScope ws) {
 					wrapPending.Wrapped(lineToWrap);
 					lineToWrap++;
 				}
+				AdjustWrapLineDuration(lineToWrap - lineFirst, etWrapping.Duration());
 
 				goodTopLine = cs.DisplayFromDoc(lineDocTop) + std::min(subLineTop, cs.GetHeight(lineDocTop)-1);
 			}
@@ -5846,6 +5879,16 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 		pdoc->DeleteUndoHistory();
 		return 0;
 
+	case SCI_GETUNDOMEMORYUSAGE:
+		return pdoc->UndoMemoryUsage();
+
+	case SCI_SETUNDOMEMORYLIMIT:
+		pdoc->SetUndoMemoryLimit(wParam);
+		return 0;
+
+	case SCI_GETUNDOMEMORYLIMIT:
+		return pdoc->UndoMemoryLimit();
+
 	case SCI_GETFIRSTVISIBLELINE:
 		return topLine;
 
@@ -6015,6 +6058,23 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 	case SCI_POSITIONRELATIVE:
 		return Platform::Clamp(pdoc->GetRelativePosition(static_cast<int>(wParam), static_cast<int>(lParam)), 0, pdoc->Length());
 
+	case SCI_GETLINECHARACTERINDEX:
+		return pdoc->LineCharacterIndex();
+
+	case SCI_ALLOCATELINECHARACTERINDEX:
+		pdoc->AllocateLineCharacterIndex(static_cast<int>(wParam));
+		break;
+
+	case SCI_RELEASELINECHARACTERINDEX:
+		pdoc->ReleaseLineCharacterIndex(static_cast<int>(wParam));
+		break;
+
+	case SCI_LINEFROMINDEXPOSITION:
+		return pdoc->LineFromIndexPosition(static_cast<int>(wParam), static_cast<int>(lParam));
+
+	case SCI_INDEXPOSITIONFROMLINE:
+		return pdoc->IndexLineStart(static_cast<int>(wParam), static_cast<int>(lParam));
+
 	case SCI_LINESCROLL:
 		ScrollTo(topLine + static_cast<int>(lParam));
 		HorizontalScrollTo(xOffset + static_cast<int>(wParam)* static_cast<int>(vs.spaceWidth));
@@ -6571,6 +6631,13 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 	case SCI_GETIDLESTYLING:
 		return idleStyling;
 
+	case SCI_SETSTYLINGCONVERGENCE:
+		pdoc->SetStylingConvergence(wParam != 0);
+		break;
+
+	case SCI_GETSTYLINGCONVERGENCE:
+		return pdoc->StylingConvergence();
+
 	case SCI_SETWRAPMODE:
 		if (vs.SetWrapState(static_cast<int>(wParam))) {
 			xOffset = 0;
@@ -6631,11 +6698,18 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 
 	case SCI_SETPOSITIONCACHE:
 		view.posCache.SetSize(wParam);
+		view.posCache.ResetStatistics();
 		break;
 
 	case SCI_GETPOSITIONCACHE:
 		return view.posCache.GetSize();
 
+	case SCI_GETPOSITIONCACHEHITS:
+		return view.posCache.Hits();
+
+	case SCI_GETPOSITIONCACHEMISSES:
+		return view.posCache.Misses();
+
 	case SCI_SETSCROLLWIDTH:
 		PLATFORM_ASSERT(wParam > 0);
 		if ((wParam > 0) && (wParam != static_cast<unsigned int >(scrollWidth))) {
@@ -257,6 +257,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 
 	// Wrapping support
 	WrapPending wrapPending;
+	double durationWrapOneLine;
 
 	bool convertPastes;
 
@@ -372,6 +373,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	bool Wrapping() const;
 	void NeedWrapping(int docLineStart=0, int docLineEnd=WrapPending::lineLarge);
 	bool WrapOneLine(Surface *surface, int lineToWrap);
+	void AdjustWrapLineDuration(int linesWrapped, double durationWrapping);
 	enum wrapScope {wsAll, wsVisible, wsIdle};
 	bool WrapLines(enum wrapScope ws);
 	void LinesJoin();
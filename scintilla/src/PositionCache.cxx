@@ -561,17 +561,18 @@ bool BreakFinder::More() const {
 }
 
 PositionCacheEntry::PositionCacheEntry() :
-	styleNumber(0), len(0), clock(0), positions(0) {
+	hash(0), clock(0), len(0), styleNumber(0), positions(0) {
 }
 
-void PositionCacheEntry::Set(unsigned int styleNumber_, const char *s_,
+void PositionCacheEntry::Set(unsigned int hash_, unsigned int styleNumber_, const char *s_,
 	unsigned int len_, XYPOSITION *positions_, unsigned int clock_) {
 	Clear();
-	styleNumber = styleNumber_;
-	len = len_;
+	hash = hash_;
+	styleNumber = static_cast<unsigned char>(styleNumber_);
+	len = static_cast<unsigned short>(len_);
 	clock = clock_;
 	if (s_ && positions_) {
-		positions = new XYPOSITION[len + (len / 4) + 1];
+		positions = new XYPOSITION[len + (len / sizeof(XYPOSITION)) + 1];
 		for (unsigned int i=0; i<len; i++) {
 			positions[i] = positions_[i];
 		}
@@ -586,14 +587,15 @@ PositionCacheEntry::~PositionCacheEntry() {
 void PositionCacheEntry::Clear() {
 	delete []positions;
 	positions = 0;
+	hash = 0;
 	styleNumber = 0;
 	len = 0;
 	clock = 0;
 }
 
-bool PositionCacheEntry::Retrieve(unsigned int styleNumber_, const char *s_,
+bool PositionCacheEntry::Retrieve(unsigned int hash_, unsigned int styleNumber_, const char *s_,
 	unsigned int len_, XYPOSITION *positions_) const {
-	if ((styleNumber == styleNumber_) && (len == len_) &&
+	if (positions && (hash == hash_) && (styleNumber == styleNumber_) && (len == len_) &&
 		(memcmp(reinterpret_cast<char *>(reinterpret_cast<void *>(positions + len)), s_, len)== 0)) {
 		for (unsigned int i=0; i<len; i++) {
 			positions_[i] = positions[i];
@@ -604,16 +606,21 @@ bool PositionCacheEntry::Retrieve(unsigned int styleNumber_, const char *s_,
 	}
 }
 
+// FNV-1a over the text followed by a final mix so that the low bits used
+// to choose a set depend on every byte.
 unsigned int PositionCacheEntry::Hash(unsigned int styleNumber_, const char *s, unsigned int len_) {
-	unsigned int ret = s[0] << 7;
+	unsigned int ret = 2166136261u;
 	for (unsigned int i=0; i<len_; i++) {
-		ret *= 1000003;
-		ret ^= s[i];
-	}
-	ret *= 1000003;
-	ret ^= len_;
-	ret *= 1000003;
-	ret ^= styleNumber_;
+		ret ^= static_cast<unsigned char>(s[i]);
+		ret *= 16777619u;
+	}
+	ret ^= (len_ << 8) | styleNumber_;
+	ret *= 16777619u;
+	ret ^= ret >> 16;
+	ret *= 0x85ebca6bu;
+	ret ^= ret >> 13;
+	ret *= 0xc2b2ae35u;
+	ret ^= ret >> 16;
 	return ret;
 }
 
@@ -631,6 +638,8 @@ PositionCache::PositionCache() {
 	clock = 1;
 	pces.resize(0x400);
 	allClear = true;
+	hits = 0;
+	misses = 0;
 }
 
 PositionCache::~PositionCache() {
@@ -649,7 +658,25 @@ void PositionCache::Clear() {
 
 void PositionCache::SetSize(size_t size_) {
 	Clear();
-	pces.resize(size_);
+	pces.resize((size_ + ways - 1) / ways * ways);
+}
+
+void PositionCache::ResetStatistics() {
+	hits = 0;
+	misses = 0;
+}
+
+unsigned int PositionCache::NextClock() {
+	clock++;
+	if (clock == 0xFFFFFFFFu) {
+		// Wrap the clock round and reset all cache entries so none get stuck
+		// with a high clock.
+		for (size_t i=0; i<pces.size(); i++) {
+			pces[i].ResetClock();
+		}
+		clock = 2;
+	}
+	return clock;
 }
 
 void PositionCache::MeasureWidths(Surface *surface, const ViewStyle &vstyle, unsigned int styleNumber,
@@ -657,24 +684,24 @@ void PositionCache::MeasureWidths(Surface *surface, const ViewStyle &vstyle, uns
 
 	allClear = false;
 	size_t probe = pces.size();	// Out of bounds
-	if ((!pces.empty()) && (len < 30)) {
-		// Only store short strings in the cache so it doesn't churn with
-		// long comments with only a single comment.
-
-		// Two way associative: try two probe positions.
-		unsigned int hashValue = PositionCacheEntry::Hash(styleNumber, s, len);
-		probe = hashValue % pces.size();
-		if (pces[probe].Retrieve(styleNumber, s, len, positions)) {
-			return;
-		}
-		unsigned int probe2 = (hashValue * 37) % pces.size();
-		if (pces[probe2].Retrieve(styleNumber, s, len, positions)) {
-			return;
-		}
-		// Not found. Choose the oldest of the two slots to replace
-		if (pces[probe].NewerThan(pces[probe2])) {
-			probe = probe2;
+	unsigned int hashValue = 0;
+	if ((!pces.empty()) && (len <= lengthMaxCached)) {
+		// Look in each way of the set for the text, remembering the least
+		// recently used entry to replace if it isn't there.
+		hashValue = PositionCacheEntry::Hash(styleNumber, s, len);
+		const size_t setStart = (hashValue % (pces.size() / ways)) * ways;
+		probe = setStart;
+		for (size_t way = setStart; way < setStart + ways; way++) {
+			if (pces[way].Retrieve(hashValue, styleNumber, s, len, positions)) {
+				pces[way].Touch(NextClock());
+				hits++;
+				return;
+			}
+			if (pces[probe].NewerThan(pces[way])) {
+				probe = way;
+			}
 		}
+		misses++;
 	}
 	if (len > BreakFinder::lengthStartSubdivision) {
 		// Break up into segments
@@ -696,15 +723,6 @@ void PositionCache::MeasureWidths(Surface *surface, const ViewStyle &vstyle, uns
 	}
 	if (probe < pces.size()) {
 		// Store into cache
-		clock++;
-		if (clock > 60000) {
-			// Since there are only 16 bits for the clock, wrap it round and
-			// reset all cache entries so none get stuck with a high clock.
-			for (size_t i=0; i<pces.size(); i++) {
-				pces[i].ResetClock();
-			}
-			clock = 2;
-		}
-		pces[probe].Set(styleNumber, s, len, positions, clock);
+		pces[probe].Set(hashValue, styleNumber, s, len, positions, NextClock());
 	}
 }
@@ -124,18 +124,22 @@ public:
 };
 
 class PositionCacheEntry {
-	unsigned int styleNumber:8;
-	unsigned int len:8;
-	unsigned int clock:16;
+	unsigned int hash;
+	unsigned int clock;
+	unsigned short len;
+	unsigned char styleNumber;
 	XYPOSITION *positions;
 public:
 	PositionCacheEntry();
 	~PositionCacheEntry();
-	void Set(unsigned int styleNumber_, const char *s_, unsigned int len_, XYPOSITION *positions_, unsigned int clock_);
+	void Set(unsigned int hash_, unsigned int styleNumber_, const char *s_, unsigned int len_,
+		XYPOSITION *positions_, unsigned int clock_);
 	void Clear();
-	bool Retrieve(unsigned int styleNumber_, const char *s_, unsigned int len_, XYPOSITION *positions_) const;
+	bool Retrieve(unsigned int hash_, unsigned int styleNumber_, const char *s_, unsigned int len_,
+		XYPOSITION *positions_) const;
 	static unsigned int Hash(unsigned int styleNumber_, const char *s, unsigned int len);
 	bool NewerThan(const PositionCacheEntry &other) const;
+	void Touch(unsigned int clock_) { clock = clock_; }
 	void ResetClock();
 };
 
@@ -201,20 +205,32 @@ public:
 	bool More() const;
 };
 
+// Set associative cache of the widths of runs of text.
 class PositionCache {
 	std::vector<PositionCacheEntry> pces;
 	unsigned int clock;
 	bool allClear;
+	size_t hits;
+	size_t misses;
+	unsigned int NextClock();
 	// Private so PositionCache objects can not be copied
 	PositionCache(const PositionCache &);
 public:
+	// Entries with the same hash modulo the number of sets compete for one set.
+	enum { ways = 4 };
+	// Every run produced by BreakFinder can be cached.
+	enum { lengthMaxCached = BreakFinder::lengthStartSubdivision };
 	PositionCache();
 	~PositionCache();
 	void Clear();
+	// The size is rounded up to a whole number of sets.
 	void SetSize(size_t size_);
 	size_t GetSize() const { return pces.size(); }
 	void MeasureWidths(Surface *surface, const ViewStyle &vstyle, unsigned int styleNumber,
 		const char *s, unsigned int len, XYPOSITION *positions, Document *pdoc);
+	size_t Hits() const { return hits; }
+	size_t Misses() const { return misses; }
+	void ResetStatistics();
 };
 
 inline bool IsSpaceOrTab(int ch) {
@@ -287,6 +287,18 @@ public:
 	int GapPosition() const {
 		return part1Length;
 	}
+
+	/// Retrieve a pointer to the elements from position up to the gap or the end
+	/// without moving the gap. rangeLength is set to the number of elements.
+	const T *ContiguousRangePointer(int position, int &rangeLength) const {
+		if (position < part1Length) {
+			rangeLength = part1Length - position;
+			return body + position;
+		} else {
+			rangeLength = lengthBody - position;
+			return body + position + gapLength;
+		}
+	}
 };
 
 #ifdef SCI_NAMESPACE
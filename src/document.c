@@ -745,6 +745,7 @@ static gboolean remove_page(guint page_num)
 
 	if (doc->priv->tag_tree)
 		gtk_widget_destroy(doc->priv->tag_tree);
+	symbols_free_tag_tree_cache(doc);
 
 	editor_destroy(doc->editor);
 	doc->editor = NULL; /* needs to be NULL for document_undo_clear() call below */
@@ -1423,6 +1424,13 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 		doc->priv->line_count = sci_get_line_count(doc->editor->sci);
 		sci_set_line_numbers(doc->editor->sci, editor_prefs.show_linenumber_margin);
 
+		/* styling and caching depend on the size of the file */
+		editor_apply_performance_profile(doc->editor);
+		/* wrapping a large file takes long, the user can still enable it for the document */
+		if (! reload &&
+			editor_get_performance_profile(doc->editor) == GEANY_PERFORMANCE_PROFILE_LARGE_FILES)
+			editor_set_line_wrapping(doc->editor, FALSE);
+
 		if (! reload)
 		{
 
@@ -82,6 +82,10 @@ typedef struct GeanyDocumentPrivate
 	GtkTreeStore	*tag_store;
 	/* Indicates whether tag tree has to be updated */
 	gboolean		tag_tree_dirty;
+	/* Tags shown in the tag tree, used to update it incrementally (see symbols.c). */
+	GPtrArray		*tag_tree_tags;
+	/* Rows of the tags shown in the tag tree (TMTag -> GtkTreeIter). */
+	GHashTable		*tag_tree_iters;
 	/* Iter for this document within the Open Files treeview of the sidebar. */
 	GtkTreeIter		 iter;
 	/* Used by the Undo/Redo management code. */
@@ -511,23 +511,45 @@ static void on_margin_click(GeanyEditor *editor, SCNotification *nt)
 }
 
 
-static void on_update_ui(GeanyEditor *editor, G_GNUC_UNUSED SCNotification *nt)
+static guint update_ui_source = 0;
+static GeanyDocument *update_ui_doc = NULL;
+
+static gboolean update_ui_idle(G_GNUC_UNUSED gpointer user_data)
 {
-	ScintillaObject *sci = editor->sci;
-	gint pos = sci_get_current_position(sci);
+	GeanyDocument *doc = update_ui_doc;
+	gint pos;
 
-	/* since Scintilla 2.24, SCN_UPDATEUI is also sent on scrolling though we don't need to handle
-	 * this and so ignore every SCN_UPDATEUI events except for content and selection changes */
-	if (! (nt->updated & SC_UPDATE_CONTENT) && ! (nt->updated & SC_UPDATE_SELECTION))
-		return;
+	update_ui_source = 0;
+	update_ui_doc = NULL;
+	if (! DOC_VALID(doc))
+		return FALSE;
+
+	pos = sci_get_current_position(doc->editor->sci);
 
 	/* undo / redo menu update */
-	ui_update_popup_reundo_items(editor->document);
+	ui_update_popup_reundo_items(doc);
 
 	/* brace highlighting */
-	editor_highlight_braces(editor, pos);
+	editor_highlight_braces(doc->editor, pos);
+
+	ui_update_statusbar(doc, pos);
+	return FALSE;
+}
+
 
-	ui_update_statusbar(editor->document, pos);
+static void on_update_ui(GeanyEditor *editor, G_GNUC_UNUSED SCNotification *nt)
+{
+	/* since Scintilla 2.24, SCN_UPDATEUI is also sent on scrolling though we don't need to handle
+	 * this and so ignore every SCN_UPDATEUI events except for content and selection changes */
+	if (! (nt->updated & SC_UPDATE_CONTENT) && ! (nt->updated & SC_UPDATE_SELECTION))
+		return;
+
+	/* SCN_UPDATEUI is sent for every caret movement, e.g. many times per frame when holding
+	 * down an arrow key or editing with multiple carets, so only update the UI once after
+	 * redrawing */
+	update_ui_doc = editor->document;
+	if (update_ui_source == 0)
+		update_ui_source = g_idle_add_full(GDK_PRIORITY_REDRAW + 10, update_ui_idle, NULL, NULL);
 
 #if 0
 	/** experimental code for inverting selections */
@@ -1140,6 +1162,7 @@ static gboolean on_editor_notify(G_GNUC_UNUSED GObject *object, GeanyEditor *edi
 			}
 			if (nt->modificationType & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT))
 			{
+				ui_update_statusbar_on_modify(doc, nt->position);
 				document_update_tag_list_in_idle(doc);
 			}
 			break;
@@ -1569,46 +1592,14 @@ static void auto_close_chars(ScintillaObject *sci, gint pos, gchar c)
 }
 
 
-/* Finds a corresponding matching brace to the given pos
- * (this is taken from Scintilla Editor.cxx,
- * fit to work with close_block) */
+/* Finds a corresponding matching brace to the given pos */
 static gint brace_match(ScintillaObject *sci, gint pos)
 {
-	gchar chBrace = sci_get_char_at(sci, pos);
-	gchar chSeek = utils_brace_opposite(chBrace);
-	gchar chAtPos;
-	gint direction = -1;
-	gint styBrace;
-	gint depth = 1;
-	gint styAtPos;
-
 	/* Hack: we need the style at @p pos but it isn't computed yet, so force styling
 	 * of this very position */
 	sci_colourise(sci, pos, pos + 1);
 
-	styBrace = sci_get_style_at(sci, pos);
-
-	if (utils_is_opening_brace(chBrace, editor_prefs.brace_match_ltgt))
-		direction = 1;
-
-	pos += direction;
-	while ((pos >= 0) && (pos < sci_get_length(sci)))
-	{
-		chAtPos = sci_get_char_at(sci, pos);
-		styAtPos = sci_get_style_at(sci, pos);
-
-		if ((pos > sci_get_end_styled(sci)) || (styAtPos == styBrace))
-		{
-			if (chAtPos == chBrace)
-				depth++;
-			if (chAtPos == chSeek)
-				depth--;
-			if (depth == 0)
-				return pos;
-		}
-		pos += direction;
-	}
-	return -1;
+	return sci_find_matching_brace(sci, pos);
 }
 
 
@@ -4923,7 +4914,11 @@ static ScintillaObject *create_new_sci(GeanyEditor *editor)
 
 	/* virtual space */
 	SSM(sci, SCI_SETVIRTUALSPACEOPTIONS, editor_prefs.show_virtual_space, 0);
-	
+
+	/* report text changes to assistive technologies once per main loop iteration, so that
+	 * reloading or replacing in large documents doesn't send an event per modification */
+	SSM(sci, SCI_SETACCESSIBILITYCOALESCING, 1, 0);
+
 #ifdef GDK_WINDOWING_QUARTZ
 # if ! GTK_CHECK_VERSION(3,16,0)
 	/* "retina" (HiDPI) display support on OS X - requires disabling buffered draw
@@ -5182,6 +5177,70 @@ void editor_apply_update_prefs(GeanyEditor *editor)
 	sci_set_scroll_stop_at_last_line(sci, editor_prefs.scroll_stop_at_last_line);
 
 	sci_set_scrollbar_mode(sci, editor_prefs.show_scrollbars);
+
+	editor_apply_performance_profile(editor);
+}
+
+
+typedef struct PerformanceProfile
+{
+	gint idle_styling;
+	gint layout_cache;
+	gint position_cache_size;
+	gint undo_memory_limit;	/* in MiB, used when the undo_memory_limit pref isn't set */
+}
+PerformanceProfile;
+
+/* indexed by GeanyPerformanceProfile */
+static const PerformanceProfile performance_profiles[GEANY_PERFORMANCE_PROFILE_COUNT] = {
+	{ SC_IDLESTYLING_NONE, SC_CACHE_CARET, 1024, 0 },	/* auto, unused */
+	{ SC_IDLESTYLING_NONE, SC_CACHE_CARET, 1024, 0 },	/* default */
+	{ SC_IDLESTYLING_ALL, SC_CACHE_PAGE, 4096, 0 },	/* large files */
+	{ SC_IDLESTYLING_AFTERVISIBLE, SC_CACHE_CARET, 256, 16 }	/* low memory */
+};
+
+
+/* Gets the profile for the editor from the project, the prefs or the size of the document */
+GeanyPerformanceProfile editor_get_performance_profile(GeanyEditor *editor)
+{
+	gint profile = editor_prefs.performance_profile;
+
+	g_return_val_if_fail(editor != NULL, GEANY_PERFORMANCE_PROFILE_DEFAULT);
+
+	if (app->project && app->project->priv->performance_profile != GEANY_PERFORMANCE_PROFILE_AUTO)
+		profile = app->project->priv->performance_profile;
+
+	if (profile <= GEANY_PERFORMANCE_PROFILE_AUTO || profile >= GEANY_PERFORMANCE_PROFILE_COUNT)
+	{
+		gsize size = (gsize) sci_get_length(editor->sci);
+
+		if (editor_prefs.large_file_size > 0 &&
+			size >= (gsize) editor_prefs.large_file_size * 1024 * 1024)
+			profile = GEANY_PERFORMANCE_PROFILE_LARGE_FILES;
+		else
+			profile = GEANY_PERFORMANCE_PROFILE_DEFAULT;
+	}
+	return profile;
+}
+
+
+void editor_apply_performance_profile(GeanyEditor *editor)
+{
+	const PerformanceProfile *profile;
+	gint undo_memory_limit;
+
+	g_return_if_fail(editor != NULL);
+
+	profile = &performance_profiles[editor_get_performance_profile(editor)];
+
+	SSM(editor->sci, SCI_SETIDLESTYLING, profile->idle_styling, 0);
+	SSM(editor->sci, SCI_SETLAYOUTCACHE, profile->layout_cache, 0);
+	SSM(editor->sci, SCI_SETPOSITIONCACHE, editor_prefs.position_cache_size > 0 ?
+		editor_prefs.position_cache_size : profile->position_cache_size, 0);
+
+	undo_memory_limit = editor_prefs.undo_memory_limit > 0 ?
+		editor_prefs.undo_memory_limit : profile->undo_memory_limit;
+	sci_set_undo_memory_limit(editor->sci, (gsize) undo_memory_limit * 1024 * 1024);
 }
 
 
@@ -137,6 +137,10 @@ typedef struct GeanyEditorPrefs
 	gboolean	long_line_enabled;
 	gint		autocompletion_update_freq;
 	gint		scroll_lines_around_cursor;
+	gint		undo_memory_limit;	/* hidden pref, in MiB, 0 for no limit */
+	gint		performance_profile;	/* hidden pref, GeanyPerformanceProfile */
+	gint		large_file_size;	/* hidden pref, in MiB */
+	gint		position_cache_size;	/* hidden pref, 0 to use the performance profile's */
 }
 GeanyEditorPrefs;
 
@@ -207,6 +211,17 @@ typedef enum
 }
 GeanyVirtualSpace;
 
+/* Scintilla styling and caching settings, chosen by document size unless set explicitly */
+typedef enum
+{
+	GEANY_PERFORMANCE_PROFILE_AUTO = 0,
+	GEANY_PERFORMANCE_PROFILE_DEFAULT,
+	GEANY_PERFORMANCE_PROFILE_LARGE_FILES,
+	GEANY_PERFORMANCE_PROFILE_LOW_MEMORY,
+	GEANY_PERFORMANCE_PROFILE_COUNT
+}
+GeanyPerformanceProfile;
+
 /* Auto-close brackets/quotes */
 enum {
 	GEANY_AC_PARENTHESIS	= 1,
@@ -324,6 +339,10 @@ void editor_set_indentation_guides(GeanyEditor *editor);
 
 void editor_apply_update_prefs(GeanyEditor *editor);
 
+GeanyPerformanceProfile editor_get_performance_profile(GeanyEditor *editor);
+
+void editor_apply_performance_profile(GeanyEditor *editor);
+
 gchar *editor_get_calltip_text(GeanyEditor *editor, const TMTag *tag);
 
 void editor_toggle_fold(GeanyEditor *editor, gint line, gint modifiers);
@@ -1063,6 +1063,52 @@ void highlighting_init_styles(guint filetype_idx, GKeyFile *config, GKeyFile *co
 }
 
 
+/* Lets restyling after an edit stop once the lexer gets back into the state it had there
+ * before. Only lexers known to keep all their state in styles, line states and fold levels
+ * allow this: they don't remember data of their own for each line nor look back at the text
+ * of earlier lines, so new lexers don't get it until they are checked. */
+static void set_styling_convergence(ScintillaObject *sci)
+{
+	gboolean convergence;
+
+	switch (SSM(sci, SCI_GETLEXER, 0, 0))
+	{
+		case SCLEX_ABAQUS:
+		case SCLEX_ADA:
+		case SCLEX_ASM:
+		case SCLEX_BATCH:
+		case SCLEX_CMAKE:
+		case SCLEX_COBOL:
+		case SCLEX_D:
+		case SCLEX_DIFF:
+		case SCLEX_ERLANG:
+		case SCLEX_F77:
+		case SCLEX_FORTH:
+		case SCLEX_FORTRAN:
+		case SCLEX_FREEBASIC:
+		case SCLEX_LISP:
+		case SCLEX_LUA:
+		case SCLEX_MAKEFILE:
+		case SCLEX_NSIS:
+		case SCLEX_OCTAVE:
+		case SCLEX_PASCAL:
+		case SCLEX_PO:
+		case SCLEX_POWERSHELL:
+		case SCLEX_PROPERTIES:
+		case SCLEX_PYTHON:
+		case SCLEX_R:
+		case SCLEX_RUST:
+		case SCLEX_TCL:
+		case SCLEX_VHDL:
+			convergence = TRUE;
+			break;
+		default:
+			convergence = FALSE;
+	}
+	SSM(sci, SCI_SETSTYLINGCONVERGENCE, convergence, 0);
+}
+
+
 #define styleset_case(LANG_NAME) \
 	case (GEANY_FILETYPES_##LANG_NAME): \
 		styleset_from_mapping(sci, ft->id, highlighting_lexer_##LANG_NAME, \
@@ -1156,6 +1202,7 @@ void highlighting_set_styles(ScintillaObject *sci, GeanyFiletype *ft)
 			val++;
 		}
 	}
+	set_styling_convergence(sci);
 }
 
 
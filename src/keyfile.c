@@ -236,6 +236,14 @@ static void init_pref_groups(void)
 		"use_gtk_word_boundaries", TRUE);
 	stash_group_add_boolean(group, &editor_prefs.complete_snippets_whilst_editing,
 		"complete_snippets_whilst_editing", FALSE);
+	stash_group_add_integer(group, &editor_prefs.undo_memory_limit,
+		"undo_memory_limit", 0);
+	stash_group_add_integer(group, &editor_prefs.performance_profile,
+		"performance_profile", GEANY_PERFORMANCE_PROFILE_AUTO);
+	stash_group_add_integer(group, &editor_prefs.large_file_size,
+		"large_file_size", 8);
+	stash_group_add_integer(group, &editor_prefs.position_cache_size,
+		"position_cache_size", 0);
 	stash_group_add_boolean(group, &file_prefs.use_safe_file_saving,
 		atomic_file_saving_key, FALSE);
 	stash_group_add_boolean(group, &file_prefs.gio_unsafe_save_backup,
@@ -251,6 +259,8 @@ static void init_pref_groups(void)
 		"indent_hard_tab_width", 8);
 	stash_group_add_integer(group, (gint*)&search_prefs.find_selection_type,
 		"find_selection_type", GEANY_FIND_SEL_CURRENT_WORD);
+	stash_group_add_boolean(group, &search_prefs.regex_literal_prefilter,
+		"regex_literal_prefilter", TRUE);
 	stash_group_add_string(group, &file_prefs.extract_filetype_regex,
 		"extract_filetype_regex", GEANY_DEFAULT_FILETYPE_REGEX);
 	stash_group_add_boolean(group, &search_prefs.replace_and_find_by_default,
@@ -1215,17 +1225,30 @@ static gboolean open_session_file(gchar **tmp, guint len)
 void configuration_open_files(void)
 {
 	gint i;
+	guint j;
+	gchar **tmp;
 	gboolean failure = FALSE;
 
 	/* necessary to set it to TRUE for project session support */
 	main_status.opening_session_files = TRUE;
 
+	/* start reading the global tags of the files' filetypes while they are opened */
+	foreach_ptr_array(tmp, j, session_files)
+	{
+		GeanyFiletype *ft = (tmp != NULL && g_strv_length(tmp) >= 8) ?
+			filetypes_lookup_by_name(tmp[1]) : NULL;
+
+		if (ft != NULL && ft->id != GEANY_FILETYPES_NONE)
+			symbols_global_tags_loaded(ft->id);
+	}
+
 	i = file_prefs.tab_order_ltr ? 0 : (session_files->len - 1);
 	while (TRUE)
 	{
-		gchar **tmp = g_ptr_array_index(session_files, i);
 		guint len;
 
+		tmp = g_ptr_array_index(session_files, i);
+
 		if (tmp != NULL && (len = g_strv_length(tmp)) >= 8)
 		{
 			if (! open_session_file(tmp, len))
@@ -1062,6 +1062,8 @@ static gboolean load_config(const gchar *filename)
 		"long_line_behaviour", 1 /* follow global */);
 	p->priv->long_line_column = utils_get_setting_integer(config, "long line marker",
 		"long_line_column", editor_prefs.long_line_column);
+	p->priv->performance_profile = utils_get_setting_integer(config, "editor",
+		"performance_profile", GEANY_PERFORMANCE_PROFILE_AUTO);
 	apply_editor_prefs();
 
 	build_load_menu(config, GEANY_BCS_PROJ, (gpointer)p);
@@ -1129,6 +1131,8 @@ static gboolean write_config(gboolean emit_signal)
 	// editor settings
 	g_key_file_set_integer(config, "long line marker", "long_line_behaviour", p->priv->long_line_behaviour);
 	g_key_file_set_integer(config, "long line marker", "long_line_column", p->priv->long_line_column);
+	if (p->priv->performance_profile != GEANY_PERFORMANCE_PROFILE_AUTO)
+		g_key_file_set_integer(config, "editor", "performance_profile", p->priv->performance_profile);
 
 	/* store the session files into the project too */
 	if (project_prefs.project_session)
@@ -44,6 +44,7 @@ typedef struct GeanyProjectPrivate
 	gboolean	auto_continue_multiline;
 	gint		long_line_behaviour; /* 0 - disabled, 1 - follow global settings, 2 - enabled (custom) */
 	gint		long_line_column; /* Long line marker position. */
+	gint		performance_profile; /* GeanyPerformanceProfile, 0 - follow global settings */
 
 	GPtrArray *build_filetypes_list; /* Project has custom filetype builds for these. */
 }
@@ -249,6 +249,27 @@ void sci_empty_undo_buffer(ScintillaObject *sci)
 }
 
 
+/* limit in bytes, 0 for no limit. The oldest undo actions are dropped when it is exceeded. */
+void sci_set_undo_memory_limit(ScintillaObject *sci, gsize limit)
+{
+	SSM(sci, SCI_SETUNDOMEMORYLIMIT, limit, 0);
+}
+
+
+gsize sci_get_undo_memory_usage(ScintillaObject *sci)
+{
+	return (gsize) SSM(sci, SCI_GETUNDOMEMORYUSAGE, 0, 0);
+}
+
+
+/* how often text measurements were found in Scintilla's position cache */
+void sci_get_position_cache_stats(ScintillaObject *sci, gulong *hits, gulong *misses)
+{
+	*hits = (gulong) SSM(sci, SCI_GETPOSITIONCACHEHITS, 0, 0);
+	*misses = (gulong) SSM(sci, SCI_GETPOSITIONCACHEMISSES, 0, 0);
+}
+
+
 gboolean sci_is_modified(ScintillaObject *sci)
 {
 	return (SSM(sci, SCI_GETMODIFY, 0, 0) != 0);
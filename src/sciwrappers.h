@@ -112,6 +112,9 @@ gboolean			sci_can_undo				(ScintillaObject *sci);
 void 				sci_undo					(ScintillaObject *sci);
 void 				sci_redo					(ScintillaObject *sci);
 void 				sci_empty_undo_buffer		(ScintillaObject *sci);
+void				sci_set_undo_memory_limit	(ScintillaObject *sci, gsize limit);
+gsize				sci_get_undo_memory_usage	(ScintillaObject *sci);
+void				sci_get_position_cache_stats	(ScintillaObject *sci, gulong *hits, gulong *misses);
 gboolean			sci_is_modified				(ScintillaObject *sci);
 
 void				sci_set_visible_eols		(ScintillaObject *sci, gboolean set);
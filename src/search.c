@@ -32,6 +32,7 @@
 
 #include "app.h"
 #include "document.h"
+#include "documentprivate.h"
 #include "encodings.h"
 #include "encodingsprivate.h"
 #include "keyfile.h"
@@ -41,6 +42,7 @@
 #include "spawn.h"
 #include "stash.h"
 #include "support.h"
+#include "tm_workspace.h"
 #include "toolbar.h"
 #include "ui_utils.h"
 #include "utils.h"
@@ -113,6 +115,17 @@ static StashGroup *fif_prefs = NULL;
 static StashGroup *find_prefs = NULL;
 static StashGroup *replace_prefs = NULL;
 
+/* the regex last used by search_find_next() and search_find_text(), as these get called
+ * repeatedly with the same pattern when marking or replacing all matches */
+static struct
+{
+	gchar *pattern;
+	GeanyFindFlags flags;
+	GRegex *regex;
+	gchar *literal;	/* text all matches contain, or NULL */
+}
+regex_cache = {NULL, 0, NULL, NULL};
+
 
 static struct
 {
@@ -291,6 +304,10 @@ void search_finalize(void)
 	FREE_WIDGET(fif_dlg.dialog);
 	g_free(search_data.text);
 	g_free(search_data.original_text);
+	g_free(regex_cache.pattern);
+	g_free(regex_cache.literal);
+	if (regex_cache.regex)
+		g_regex_unref(regex_cache.regex);
 }
 
 
@@ -1923,10 +1940,260 @@ static gchar *get_regex_match_string(const gchar *text, const GeanyMatchInfo *ma
 }
 
 
-static gint find_regex(ScintillaObject *sci, guint pos, GRegex *regex, gboolean multiline, GeanyMatchInfo *match)
+/* Skips a quantifier at p, including a lazy or possessive suffix, and sets min to
+ * the least number of repetitions it allows. Returns p if there is none. */
+static const gchar *skip_regex_quantifier(const gchar *p, guint *min)
+{
+	const gchar *q = p;
+
+	*min = 1;
+	if (*q == '?' || *q == '*')
+	{
+		*min = 0;
+		q++;
+	}
+	else if (*q == '+')
+		q++;
+	else if (*q == '{' && g_ascii_isdigit(q[1]))
+	{
+		*min = (guint) strtoul(q + 1, (gchar **) &q, 10);
+		if (*q == ',')
+		{
+			q++;
+			while (g_ascii_isdigit(*q))
+				q++;
+		}
+		if (*q != '}')
+		{
+			/* not a quantifier but a literal brace */
+			*min = 1;
+			return p;
+		}
+		q++;
+	}
+	else
+		return p;
+
+	if (*q == '?' || *q == '+')
+		q++;
+	return q;
+}
+
+
+/* Skips the group or character class starting at p, returns NULL if it isn't terminated. */
+static const gchar *skip_regex_group(const gchar *p)
+{
+	gint depth = 0;
+
+	do
+	{
+		if (*p == '\\')
+		{
+			if (! p[1])
+				return NULL;
+			p += 2;
+			continue;
+		}
+		if (*p == '[')
+		{
+			/* a ']' first in a class is literal */
+			p++;
+			if (*p == '^')
+				p++;
+			if (*p == ']')
+				p++;
+			while (*p != ']')
+			{
+				if (! *p)
+					return NULL;
+				if (*p == '\\' && p[1])
+					p++;
+				else if (*p == '[' && p[1] == ':')
+				{
+					/* POSIX class like [:alpha:] */
+					const gchar *end = strstr(p + 2, ":]");
+					if (! end)
+						return NULL;
+					p = end + 1;
+				}
+				p++;
+			}
+		}
+		else if (*p == '(')
+			depth++;
+		else if (*p == ')')
+			depth--;
+		else if (! *p)
+			return NULL;
+		p++;
+	}
+	while (depth > 0);
+
+	return p;
+}
+
+
+/* Gets the longest text that must appear literally in all matches of pattern, to look for
+ * it before trying the regex. The pattern is parsed conservatively and NULL is returned for
+ * anything not understood, as well as for alternatives at top level.
+ * Caseless, only ASCII is used and not 'k' and 's' which match some other characters with
+ * Unicode case folding. */
+static gchar *get_regex_literal(const gchar *pattern, gboolean caseless)
+{
+	GString *run = g_string_new(NULL);
+	gchar *literal = NULL;
+	gsize literal_len = 0;
+	const gchar *p = pattern;
+
+	while (*p)
+	{
+		const gchar *atom = p;
+		const gchar *atom_end;
+		gboolean is_literal = FALSE;
+		guint min;
+
+		switch (*p)
+		{
+			case '|':
+			case ')':
+			case '*':
+			case '+':
+			case '?':
+				goto fail;
+			case '(':
+				/* inline options would change how the rest matches */
+				if (p[1] == '*' || (p[1] == '?' && ! strchr(":=!<", p[2])) ||
+					(p[1] == '?' && p[2] == '<' && ! strchr("=!", p[3])))
+					goto fail;
+				/* fall through */
+			case '[':
+				atom_end = skip_regex_group(p);
+				if (! atom_end)
+					goto fail;
+				break;
+			case '\\':
+				if (! p[1] || (guchar) p[1] >= 0x80)
+					goto fail;
+				if (g_ascii_isalnum(p[1]))
+				{
+					/* character types and assertions, give up on escapes with arguments */
+					if (! strchr("dDwWsSbBhHvVRNAzZGX", p[1]))
+						goto fail;
+				}
+				else
+				{
+					atom++;
+					is_literal = TRUE;
+				}
+				atom_end = p + 2;
+				break;
+			case '.':
+			case '^':
+			case '$':
+				atom_end = p + 1;
+				break;
+			default:
+				atom_end = g_utf8_next_char(p);
+				is_literal = ! caseless ||
+					((guchar) *p < 0x80 && ! strchr("kKsS", *p));
+				break;
+		}
+
+		p = skip_regex_quantifier(atom_end, &min);
+		if (is_literal && min > 0)
+			g_string_append_len(run, atom, atom_end - atom);
+		/* a repeated or optional atom can't be followed by more of the run */
+		if (! is_literal || p != atom_end)
+		{
+			if (run->len > literal_len)
+			{
+				SETPTR(literal, g_strndup(run->str, run->len));
+				literal_len = run->len;
+			}
+			g_string_truncate(run, 0);
+		}
+	}
+	if (run->len > literal_len)
+		SETPTR(literal, g_strndup(run->str, run->len));
+	g_string_free(run, TRUE);
+	return literal;
+
+fail:
+	g_string_free(run, TRUE);
+	g_free(literal);
+	return NULL;
+}
+
+
+/* Like memmem(), ignoring ASCII case if caseless. */
+static const gchar *find_literal(const gchar *text, gsize len, const gchar *literal,
+		gsize literal_len, gboolean caseless)
+{
+	const gchar *end = text + len;
+	const gchar *next_lower, *next_upper;
+	gchar lower = caseless ? g_ascii_tolower(literal[0]) : literal[0];
+	gchar upper = caseless ? g_ascii_toupper(literal[0]) : literal[0];
+
+	if (literal_len > len)
+		return NULL;
+	end -= literal_len - 1;
+
+	next_lower = memchr(text, lower, end - text);
+	next_upper = (upper != lower) ? memchr(text, upper, end - text) : NULL;
+	while (next_lower || next_upper)
+	{
+		const gchar *candidate;
+
+		/* take the nearest of both cases, keeping the other for later */
+		if (next_lower && (! next_upper || next_lower < next_upper))
+		{
+			candidate = next_lower;
+			next_lower = memchr(candidate + 1, lower, end - candidate - 1);
+		}
+		else
+		{
+			candidate = next_upper;
+			next_upper = memchr(candidate + 1, upper, end - candidate - 1);
+		}
+
+		if (caseless ? g_ascii_strncasecmp(candidate + 1, literal + 1, literal_len - 1) == 0 :
+				memcmp(candidate + 1, literal + 1, literal_len - 1) == 0)
+			return candidate;
+	}
+	return NULL;
+}
+
+
+/* Gets the compiled regex for str, reusing the last one if possible.
+ * The returned regex is owned by the cache, as is literal if set. */
+static GRegex *get_search_regex(const gchar *str, GeanyFindFlags flags, const gchar **literal)
+{
+	if (! regex_cache.regex || regex_cache.flags != flags || ! utils_str_equal(regex_cache.pattern, str))
+	{
+		GRegex *regex = compile_regex(str, flags);
+
+		if (! regex)
+			return NULL;
+
+		if (regex_cache.regex)
+			g_regex_unref(regex_cache.regex);
+		regex_cache.regex = regex;
+		regex_cache.flags = flags;
+		SETPTR(regex_cache.pattern, g_strdup(str));
+		SETPTR(regex_cache.literal, get_regex_literal(str, ~flags & GEANY_FIND_MATCHCASE));
+	}
+	*literal = search_prefs.regex_literal_prefilter ? regex_cache.literal : NULL;
+	return regex_cache.regex;
+}
+
+
+/* literal is text all matches contain, if known; in single-line mode then only the lines
+ * containing it are matched against the regex */
+static gint find_regex(ScintillaObject *sci, guint pos, GRegex *regex, const gchar *literal,
+		gboolean multiline, GeanyMatchInfo *match)
 {
 	const gchar *text;
-	GMatchInfo *minfo;
+	GMatchInfo *minfo = NULL;
 	guint document_length;
 	gint ret = -1;
 	gint offset = 0;
@@ -1946,11 +2213,42 @@ static gint find_regex(ScintillaObject *sci, guint pos, GRegex *regex, gboolean
 	else /* single-line mode, manually match against each line */
 	{
 		gint line = sci_get_line_from_position(sci, pos);
+		gsize literal_len = literal ? strlen(literal) : 0;
+		gboolean caseless = g_regex_get_compile_flags(regex) & G_REGEX_CASELESS;
+		const gchar *rest = NULL;
+		gint rest_start = 0;
+
+		if (literal_len > 0)
+		{
+			/* the text from the first line on; getting line ranges from it afterwards
+			 * won't move the gap and so won't invalidate it */
+			rest_start = sci_get_position_from_line(sci, line);
+			rest = (void*)scintilla_send_message(sci, SCI_GETRANGEPOINTER,
+				rest_start, document_length - rest_start);
+		}
 
 		for (;;)
 		{
-			gint start = sci_get_position_from_line(sci, line);
-			gint end = sci_get_line_end_position(sci, line);
+			gint start, end;
+
+			if (rest)
+			{
+				/* skip lines not containing the literal */
+				const gchar *found = find_literal(rest + (pos - rest_start), document_length - pos,
+					literal, literal_len, caseless);
+				gint found_line;
+
+				if (! found)
+					break;
+				found_line = sci_get_line_from_position(sci, rest_start + (found - rest));
+				if (found_line > line)
+				{
+					line = found_line;
+					pos = sci_get_position_from_line(sci, line);
+				}
+			}
+			start = sci_get_position_from_line(sci, line);
+			end = sci_get_line_end_position(sci, line);
 
 			text = (void*)scintilla_send_message(sci, SCI_GETRANGEPOINTER, start, end - start);
 			if (g_regex_match_full(regex, text, end - start, pos - start, 0, &minfo, NULL))
@@ -1960,18 +2258,18 @@ static gint find_regex(ScintillaObject *sci, guint pos, GRegex *regex, gboolean
 			}
 			else /* not found, try next line */
 			{
+				g_match_info_free(minfo);
+				minfo = NULL;
 				line ++;
 				if (line >= sci_get_line_count(sci))
 					break;
 				pos = sci_get_position_from_line(sci, line);
-				/* don't free last info, it's freed below */
-				g_match_info_free(minfo);
 			}
 		}
 	}
 
 	/* Warning: minfo will become invalid when 'text' does! */
-	if (g_match_info_matches(minfo))
+	if (minfo && g_match_info_matches(minfo))
 	{
 		guint i;
 
@@ -1990,7 +2288,8 @@ static gint find_regex(ScintillaObject *sci, guint pos, GRegex *regex, gboolean
 		match->end = match->matches[0].end;
 		ret = match->start;
 	}
-	g_match_info_free(minfo);
+	if (minfo)
+		g_match_info_free(minfo);
 	return ret;
 }
 
@@ -2023,6 +2322,7 @@ gint search_find_next(ScintillaObject *sci, const gchar *str, GeanyFindFlags fla
 {
 	GeanyMatchInfo *match;
 	GRegex *regex;
+	const gchar *literal;
 	gint ret = -1;
 	gint pos;
 
@@ -2034,17 +2334,17 @@ gint search_find_next(ScintillaObject *sci, const gchar *str, GeanyFindFlags fla
 		return ret;
 	}
 
-	regex = compile_regex(str, flags);
+	regex = get_search_regex(str, flags, &literal);
 	if (!regex)
 		return -1;
 
 	match = match_info_new(flags, 0, 0);
 
 	pos = sci_get_current_position(sci);
-	ret = find_regex(sci, pos, regex, flags & GEANY_FIND_MULTILINE, match);
+	ret = find_regex(sci, pos, regex, literal, flags & GEANY_FIND_MULTILINE, match);
 	/* avoid re-matching the same position in case of empty matches */
 	if (ret == pos && match->matches[0].start == match->matches[0].end)
-		ret = find_regex(sci, pos + 1, regex, flags & GEANY_FIND_MULTILINE, match);
+		ret = find_regex(sci, pos + 1, regex, literal, flags & GEANY_FIND_MULTILINE, match);
 	if (ret >= 0)
 		sci_set_selection(sci, match->start, match->end);
 
@@ -2053,7 +2353,6 @@ gint search_find_next(ScintillaObject *sci, const gchar *str, GeanyFindFlags fla
 	else
 		geany_match_info_free(match);
 
-	g_regex_unref(regex);
 	return ret;
 }
 
@@ -2108,6 +2407,7 @@ gint search_find_text(ScintillaObject *sci, GeanyFindFlags flags, struct Sci_Tex
 {
 	GeanyMatchInfo *match = NULL;
 	GRegex *regex;
+	const gchar *literal;
 	gint ret;
 
 	if (~flags & GEANY_FIND_REGEXP)
@@ -2118,13 +2418,13 @@ gint search_find_text(ScintillaObject *sci, GeanyFindFlags flags, struct Sci_Tex
 		return ret;
 	}
 
-	regex = compile_regex(ttf->lpstrText, flags);
+	regex = get_search_regex(ttf->lpstrText, flags, &literal);
 	if (!regex)
 		return -1;
 
 	match = match_info_new(flags, 0, 0);
 
-	ret = find_regex(sci, ttf->chrg.cpMin, regex, flags & GEANY_FIND_MULTILINE, match);
+	ret = find_regex(sci, ttf->chrg.cpMin, regex, literal, flags & GEANY_FIND_MULTILINE, match);
 	if (ret >= ttf->chrg.cpMax)
 		ret = -1;
 	else if (ret >= 0)
@@ -2138,7 +2438,6 @@ gint search_find_text(ScintillaObject *sci, GeanyFindFlags flags, struct Sci_Tex
 	else
 		geany_match_info_free(match);
 
-	g_regex_unref(regex);
 	return ret;
 }
 
@@ -2183,6 +2482,149 @@ static gint find_document_usage(GeanyDocument *doc, const gchar *search_text, Ge
 }
 
 
+/* Checks whether the tag manager's occurrence index can answer a search for search_text */
+static gboolean occurrence_index_applies(const gchar *search_text, GeanyFindFlags flags)
+{
+	const gchar *p;
+
+	/* the index only knows whole, case sensitive ASCII identifiers */
+	if (flags != (GEANY_FIND_MATCHCASE | GEANY_FIND_WHOLEWORD))
+		return FALSE;
+
+	for (p = search_text; *p; p++)
+	{
+		if (! g_ascii_isalnum(*p) && *p != '_')
+			return FALSE;
+	}
+	return TRUE;
+}
+
+
+/* Like Scintilla's default word characters, non-ASCII letters and digits are part of words */
+static gboolean is_usage_word_char(const gchar *p)
+{
+	if ((guchar) *p < 0x80)
+		return g_ascii_isalnum(*p) || *p == '_';
+	return g_unichar_isalnum(g_utf8_get_char_validated(p, -1));
+}
+
+
+/* Counts the whole word occurrences of search_text in the line [start, end) */
+static gint count_line_usage(const gchar *start, const gchar *end, const gchar *search_text)
+{
+	gsize len = strlen(search_text);
+	const gchar *p = start;
+	gint count = 0;
+
+	while ((p = g_strstr_len(p, end - p, search_text)) != NULL)
+	{
+		const gchar *prev = g_utf8_find_prev_char(start, p);
+
+		if ((prev == NULL || ! is_usage_word_char(prev)) &&
+			(p + len >= end || ! is_usage_word_char(p + len)))
+			count++;
+		p += len;
+	}
+	return count;
+}
+
+
+static gboolean is_open_source_file(TMSourceFile *source_file)
+{
+	guint i;
+
+	foreach_document(i)
+	{
+		if (documents[i]->tm_file == source_file)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+
+/* Finds the usages of search_text in a file which isn't open, converted to UTF-8 like
+ * opened files. If lines isn't NULL, only these lines are searched as the others don't
+ * contain the text. */
+static gint find_file_usage(const gchar *locale_file_name, GArray *lines,
+		const gchar *search_text)
+{
+	gchar *contents, *utf8_file_name;
+	const gchar *line_start;
+	gsize length;
+	guint j = 0, line = 1;
+	gint count = 0;
+
+	if (! g_file_get_contents(locale_file_name, &contents, &length, NULL))
+		return 0;
+
+	utf8_file_name = utils_get_utf8_from_locale(locale_file_name);
+	/* the lines are shown in the message window like those of open documents */
+	if (! encodings_convert_to_utf8_auto(&contents, &length, NULL, NULL, NULL, NULL))
+	{
+		msgwin_msg_add(COLOR_RED, -1, NULL,
+			_("Failed to convert file \"%s\" to UTF-8, it was not searched."), utf8_file_name);
+		g_free(utf8_file_name);
+		g_free(contents);
+		return 0;
+	}
+	for (line_start = contents; line_start != NULL; line++)
+	{
+		const gchar *line_end = strchr(line_start, '\n');
+
+		if (line_end == NULL)
+			line_end = line_start + strlen(line_start);
+
+		if (lines == NULL || g_array_index(lines, guint, j) == line)
+		{
+			gint line_count = count_line_usage(line_start, line_end, search_text);
+
+			if (line_count > 0)
+			{
+				gchar *buffer = g_strndup(line_start, line_end - line_start);
+
+				msgwin_msg_add(COLOR_BLACK, -1, NULL,
+					"%s:%u: %s", utf8_file_name, line, g_strstrip(buffer));
+				g_free(buffer);
+				count += line_count;
+			}
+			if (lines != NULL && ++j >= lines->len)
+				break;
+		}
+		line_start = (*line_end != '\0') ? line_end + 1 : NULL;
+	}
+	g_free(utf8_file_name);
+	g_free(contents);
+	return count;
+}
+
+
+/* Finds usages in the files of the tag manager workspace which aren't open, e.g. project
+ * files added by plugins. Of the files with an occurrence index, only the lines it knows
+ * to contain search_text are read, files without one (e.g. too big ones) are searched
+ * whole. */
+static gint find_workspace_usage(const gchar *search_text, GeanyFindFlags flags)
+{
+	GPtrArray *source_files;
+	gint count = 0;
+	guint i;
+
+	if (! occurrence_index_applies(search_text, flags))
+		return 0;
+
+	source_files = tm_workspace_find_occurrences(search_text);
+	for (i = 0; i < source_files->len; i++)
+	{
+		TMSourceFile *source_file = source_files->pdata[i];
+
+		if (! is_open_source_file(source_file))
+			count += find_file_usage(source_file->file_name,
+				tm_source_file_get_occurrences(source_file, search_text), search_text);
+	}
+	g_ptr_array_free(source_files, TRUE);
+	return count;
+}
+
+
 void search_find_usage(const gchar *search_text, const gchar *original_search_text,
 		GeanyFindFlags flags, gboolean in_session)
 {
@@ -2215,6 +2657,7 @@ void search_find_usage(const gchar *search_text, const gchar *original_search_te
 				count += find_document_usage(documents[i], search_text, flags);
 			}
 		}
+		count += find_workspace_usage(search_text, flags);
 	}
 
 	if (count == 0) /* no matches were found */
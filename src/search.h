@@ -62,6 +62,7 @@ typedef struct GeanySearchPrefs
 	gboolean	hide_find_dialog;		/* hide the find dialog on next or previous */
 	gboolean	replace_and_find_by_default;	/* enter in replace window performs Replace & Find instead of Replace */
 	GeanyFindSelOptions find_selection_type;
+	gboolean	regex_literal_prefilter;	/* look for literal text of a regex before matching lines */
 }
 GeanySearchPrefs;
 
@@ -565,6 +565,7 @@ void sidebar_remove_document(GeanyDocument *doc)
 		g_object_unref(doc->priv->tag_tree);
 		doc->priv->tag_tree = NULL;
 	}
+	symbols_free_tag_tree_cache(doc);
 }
 
 
@@ -47,6 +47,7 @@
 #include "geanyobject.h"
 #include "highlighting.h"
 #include "main.h"
+#include "msgwindow.h"
 #include "navqueue.h"
 #include "sciwrappers.h"
 #include "sidebar.h"
@@ -117,6 +118,20 @@ static struct
 }
 symbol_menu;
 
+/* A global tags file read in the background */
+typedef struct
+{
+	gchar *file_name;
+	GeanyFiletype *ft;
+	GPtrArray *tags;	/* NULL until read or if reading failed */
+}
+GlobalTagsJob;
+
+/* reads the global tags files one after the other */
+static GThreadPool *global_tags_pool = NULL;
+/* number of global tags files of every filetype not added yet */
+static guint *global_tags_pending = NULL;
+
 static void load_user_tags(GeanyFiletypeID ft_id);
 
 /* get the tags_ignore list, exported by tagmanager's options.c */
@@ -175,8 +190,8 @@ static gboolean symbols_load_global_tags(const gchar *tags_file, GeanyFiletype *
 }
 
 
-/* Ensure that the global tags file(s) for the file_type_idx filetype is loaded.
- * This provides autocompletion, calltips, etc. */
+/* Ensure that the global tags file(s) for the file_type_idx filetype are loaded or being
+ * loaded in the background. This provides autocompletion, calltips, etc. */
 void symbols_global_tags_loaded(guint file_type_idx)
 {
 	/* load ignore list for C/C++ parser */
@@ -214,8 +229,9 @@ GString *symbols_find_typenames_as_string(TMParserType lang, gboolean global)
 	GPtrArray *typedefs;
 	TMParserType tag_lang;
 
+	/* the global type names are only taken from the compatible languages */
 	if (global)
-		typedefs = app->tm_workspace->global_typename_array;
+		typedefs = tm_workspace_find_global_typenames(lang);
 	else
 		typedefs = app->tm_workspace->typename_array;
 
@@ -239,6 +255,8 @@ GString *symbols_find_typenames_as_string(TMParserType lang, gboolean global)
 			}
 		}
 	}
+	if (global)
+		g_ptr_array_free(typedefs, TRUE);
 	return s;
 }
 
@@ -307,33 +325,6 @@ static gint compare_symbol_lines(gconstpointer a, gconstpointer b)
 }
 
 
-static GList *get_tag_list(GeanyDocument *doc, TMTagType tag_types)
-{
-	GList *tag_names = NULL;
-	guint i;
-
-	g_return_val_if_fail(doc, NULL);
-
-	if (! doc->tm_file || ! doc->tm_file->tags_array)
-		return NULL;
-
-	for (i = 0; i < doc->tm_file->tags_array->len; ++i)
-	{
-		TMTag *tag = TM_TAG(doc->tm_file->tags_array->pdata[i]);
-
-		if (G_UNLIKELY(tag == NULL))
-			return NULL;
-
-		if (tag->type & tag_types)
-		{
-			tag_names = g_list_prepend(tag_names, tag);
-		}
-	}
-	tag_names = g_list_sort(tag_names, compare_symbol_lines);
-	return tag_names;
-}
-
-
 /* amount of types in the symbol list (currently max. 8 are used) */
 #define MAX_SYMBOL_TYPES	(sizeof(tv_iters) / sizeof(GtkTreeIter))
 
@@ -1049,32 +1040,6 @@ static gboolean tag_equal(gconstpointer v1, gconstpointer v2)
 }
 
 
-/* inspired from g_str_hash() */
-static guint tag_hash(gconstpointer v)
-{
-	const TMTag *tag = v;
-	const gchar *p;
-	guint32 h = 5381;
-
-	h = (h << 5) + h + tag->type;
-	for (p = tag->name; *p != '\0'; p++)
-		h = (h << 5) + h + *p;
-	if (tag->scope)
-	{
-		for (p = tag->scope; *p != '\0'; p++)
-			h = (h << 5) + h + *p;
-	}
-	/* for e.g. C++ overloading */
-	if (tag->arglist)
-	{
-		for (p = tag->arglist; *p != '\0'; p++)
-			h = (h << 5) + h + *p;
-	}
-
-	return h;
-}
-
-
 /* like gtk_tree_view_expand_to_path() but with an iter */
 static void tree_view_expand_to_iter(GtkTreeView *view, GtkTreeIter *iter)
 {
@@ -1086,26 +1051,6 @@ static void tree_view_expand_to_iter(GtkTreeView *view, GtkTreeIter *iter)
 }
 
 
-/* like gtk_tree_store_remove() but finds the next iter at any level */
-static gboolean tree_store_remove_row(GtkTreeStore *store, GtkTreeIter *iter)
-{
-	GtkTreeIter parent;
-	gboolean has_parent;
-	gboolean cont;
-
-	has_parent = gtk_tree_model_iter_parent(GTK_TREE_MODEL(store), &parent, iter);
-	cont = gtk_tree_store_remove(store, iter);
-	/* if there is no next at this level but there is a parent iter, continue from it */
-	if (! cont && has_parent)
-	{
-		*iter = parent;
-		cont = ui_tree_model_iter_any_next(GTK_TREE_MODEL(store), iter, FALSE);
-	}
-
-	return cont;
-}
-
-
 static gint tree_search_func(gconstpointer key, gpointer user_data)
 {
 	TreeSearchData *data = user_data;
@@ -1193,207 +1138,367 @@ static void parents_table_value_free(gpointer data)
 }
 
 
-/* inserts a @data in @table on key @tag.
- * previous data is not overwritten if the key is duplicated, but rather the
- * two values are kept in a list
- *
- * table is: GHashTable<TMTag, GTree<line_num, GList<GList<TMTag>>>> */
-static void tags_table_insert(GHashTable *table, TMTag *tag, GList *data)
+/* we don't want to sort 1st-level nodes, but we can't return 0 because the tree sort
+ * is not stable, so the order is already lost. */
+static gint compare_top_level_names(const gchar *a, const gchar *b)
 {
-	GTree *tree = g_hash_table_lookup(table, tag);
-	if (!tree)
+	guint i;
+	const gchar *name;
+
+	/* This should never happen as it would mean that two or more top
+	 * level items have the same name but it can happen by typos in the translations. */
+	if (utils_str_equal(a, b))
+		return 1;
+
+	foreach_ptr_array(name, i, top_level_iter_names)
 	{
-		tree = g_tree_new_full(tree_cmp, NULL, NULL, NULL);
-		g_hash_table_insert(table, tag, tree);
+		if (utils_str_equal(name, a))
+			return -1;
+		if (utils_str_equal(name, b))
+			return 1;
 	}
-	GList *list = g_tree_lookup(tree, GINT_TO_POINTER(tag->line));
-	list = g_list_prepend(list, data);
-	g_tree_insert(tree, GINT_TO_POINTER(tag->line), list);
+	g_warning("Couldn't find top level node '%s' or '%s'!", a, b);
+	return 0;
 }
 
 
-/* looks up the entry in @table that best matches @tag.
- * if there is more than one candidate, the one that has closest line position to @tag is chosen */
-static GList *tags_table_lookup(GHashTable *table, TMTag *tag)
+static gboolean tag_has_missing_parent(const TMTag *tag, GtkTreeStore *store,
+		GtkTreeIter *iter)
 {
-	TreeSearchData user_data = {-1, tag->line, FALSE};
-	GTree *tree = g_hash_table_lookup(table, tag);
-
-	if (tree)
-	{
-		GList *list;
-
-		g_tree_search(tree, (GCompareFunc)tree_search_func, &user_data);
-		list = g_tree_lookup(tree, GINT_TO_POINTER(user_data.found_line));
-		/* return the first value in the list - we don't care which of the
-		 * tags with identical names defined on the same line we get */
-		if (list)
-			return list->data;
-	}
-	return NULL;
+	/* if the tag has a parent tag, it should be at depth >= 2 */
+	return !EMPTY(tag->scope) &&
+		gtk_tree_store_iter_depth(store, iter) == 1;
 }
 
 
-/* removes the element at @tag from @table.
- * @tag must be the exact pointer used at insertion time */
-static void tags_table_remove(GHashTable *table, TMTag *tag)
+static gint tree_sort_func(GtkTreeModel *model, GtkTreeIter *a, GtkTreeIter *b,
+		gpointer user_data)
 {
-	GTree *tree = g_hash_table_lookup(table, tag);
-	if (tree)
+	gboolean sort_by_name = GPOINTER_TO_INT(user_data);
+	TMTag *tag_a, *tag_b;
+	gint cmp;
+
+	gtk_tree_model_get(model, a, SYMBOLS_COLUMN_TAG, &tag_a, -1);
+	gtk_tree_model_get(model, b, SYMBOLS_COLUMN_TAG, &tag_b, -1);
+
+	/* Check if the iters can be sorted based on tag name and line, not tree item name.
+	 * Sort by tree name if the scope was prepended, e.g. 'ScopeNameWithNoTag::TagName'. */
+	if (tag_a && !tag_has_missing_parent(tag_a, GTK_TREE_STORE(model), a) &&
+		tag_b && !tag_has_missing_parent(tag_b, GTK_TREE_STORE(model), b))
 	{
-		GList *list = g_tree_lookup(tree, GINT_TO_POINTER(tag->line));
-		if (list)
+		cmp = sort_by_name ? compare_symbol(tag_a, tag_b) :
+			compare_symbol_lines(tag_a, tag_b);
+	}
+	else
+	{
+		gchar *astr, *bstr;
+
+		gtk_tree_model_get(model, a, SYMBOLS_COLUMN_NAME, &astr, -1);
+		gtk_tree_model_get(model, b, SYMBOLS_COLUMN_NAME, &bstr, -1);
+
+		/* if a is toplevel, b must be also */
+		if (gtk_tree_store_iter_depth(GTK_TREE_STORE(model), a) == 0)
 		{
-			GList *node;
-			/* should always be the first element as we returned the first one in
-			 * tags_table_lookup() */
-			foreach_list(node, list)
+			cmp = compare_top_level_names(astr, bstr);
+		}
+		else
+		{
+			/* this is what g_strcmp0() does */
+			if (! astr)
+				cmp = -(astr != bstr);
+			else if (! bstr)
+				cmp = astr != bstr;
+			else
 			{
-				if (((GList *) node->data)->data == tag)
-					break;
+				cmp = strcmp(astr, bstr);
+
+				/* sort duplicate 'ScopeName::OverloadedTagName' items by line as well */
+				if (tag_a && tag_b)
+					if (!sort_by_name ||
+						(utils_str_equal(tag_a->name, tag_b->name) &&
+							utils_str_equal(tag_a->scope, tag_b->scope)))
+						cmp = compare_symbol_lines(tag_a, tag_b);
 			}
-			list = g_list_delete_link(list, node);
-			if (!list)
-				g_tree_remove(tree, GINT_TO_POINTER(tag->line));
-			else
-				g_tree_insert(tree, GINT_TO_POINTER(tag->line), list);
 		}
+		g_free(astr);
+		g_free(bstr);
 	}
+	tm_tag_unref(tag_a);
+	tm_tag_unref(tag_b);
+
+	return cmp;
 }
 
 
-static gboolean tags_table_tree_value_free(gpointer key, gpointer value, gpointer data)
+static void sort_tree(GtkTreeStore *store, gboolean sort_by_name)
 {
-	GList *list = value;
-	g_list_free(list);
-	return FALSE;
+	gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(store), SYMBOLS_COLUMN_NAME, tree_sort_func,
+		GINT_TO_POINTER(sort_by_name), NULL);
+
+	gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(store), SYMBOLS_COLUMN_NAME, GTK_SORT_ASCENDING);
 }
 
 
-static void tags_table_value_free(gpointer data)
+/* The symbol tree is updated incrementally: the tags shown in the tree are kept
+ * (sorted like the TMSourceFile tags) together with their rows, so the new tags of the
+ * document can be diffed against them and only the rows of added, removed and changed
+ * tags have to be touched. */
+typedef struct
 {
-	GTree *tree = data;
-	if (tree)
+	GPtrArray *tags;		/* tags to show after the update (referenced), sorted like the file tags */
+	GPtrArray *added;		/* tags needing a new row */
+	GPtrArray *removed;		/* shown tags which don't exist anymore */
+	GHashTable *changed;	/* shown tag -> its new version (e.g. with a different line) */
+}
+TagTreeDiff;
+
+
+/* Frees the data used to update the symbol tree of @a doc incrementally. Must be called
+ * whenever the rows of the tag store are destroyed. */
+void symbols_free_tag_tree_cache(GeanyDocument *doc)
+{
+	if (doc->priv->tag_tree_iters)
 	{
-		/* free any leftover elements.  note that we can't register a value_free_func when
-		 * creating the tree because we only want to free it when destroying the tree,
-		 * not when inserting a duplicate (we handle this manually) */
-		g_tree_foreach(tree, tags_table_tree_value_free, NULL);
-		g_tree_destroy(tree);
+		g_hash_table_destroy(doc->priv->tag_tree_iters);
+		doc->priv->tag_tree_iters = NULL;
+	}
+	if (doc->priv->tag_tree_tags)
+	{
+		tm_tags_array_free(doc->priv->tag_tree_tags, TRUE);
+		doc->priv->tag_tree_tags = NULL;
 	}
 }
 
 
-/*
- * Updates the tag tree for a document with the tags in *list.
- * @param doc a document
- * @param tags a pointer to a GList* holding the tags to add/update.  This
- *             list may be updated, removing updated elements.
- *
- * The update is done in two passes:
- * 1) walking the current tree, update tags that still exist and remove the
- *    obsolescent ones;
- * 2) walking the remaining (non updated) tags, adds them in the list.
- *
- * For better performances, we use 2 hash tables:
- * - one containing all the tags for lookup in the first pass (actually stores a
- *   reference in the tags list for removing it efficiently), avoiding list search
- *   on each tag;
- * - the other holding "tag-name":row references for tags having children, used to
- *   lookup for a parent in both passes, avoiding tree traversal.
- */
-static void update_tree_tags(GeanyDocument *doc, GList **tags)
+/* matches the tags of a group of equally named shown and new tags, in order */
+static void diff_tag_group(TagTreeDiff *diff, GPtrArray *old_tags, guint old_start, guint old_end,
+		GPtrArray *new_tags, guint new_start, guint new_end)
 {
-	GtkTreeStore *store = doc->priv->tag_store;
-	GtkTreeModel *model = GTK_TREE_MODEL(store);
-	GHashTable *parents_table;
-	GHashTable *tags_table;
-	GtkTreeIter iter;
-	gboolean cont;
-	GList *item;
+	guint n_old = old_end - old_start;
+	gboolean *matched = g_new0(gboolean, n_old);
+	guint i, j;
 
-	/* Build hash tables holding tags and parents */
-	/* parent table is GHashTable<tag_name, GTree<line_num, GtkTreeIter>> */
-	parents_table = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, parents_table_value_free);
-	/* tags table is another representation of the @tags list,
-	 * GHashTable<TMTag, GTree<line_num, GList<GList<TMTag>>>> */
-	tags_table = g_hash_table_new_full(tag_hash, tag_equal, NULL, tags_table_value_free);
-	foreach_list(item, *tags)
+	for (j = new_start; j < new_end; j++)
+	{
+		TMTag *new_tag = new_tags->pdata[j];
+		TMTag *old_tag = NULL;
+
+		for (i = 0; i < n_old; i++)
+		{
+			if (! matched[i] && tag_equal(old_tags->pdata[old_start + i], new_tag))
+			{
+				matched[i] = TRUE;
+				old_tag = old_tags->pdata[old_start + i];
+				break;
+			}
+		}
+
+		if (! old_tag)
+			g_ptr_array_add(diff->added, new_tag);
+		else if (old_tag != new_tag && ! tm_tags_equal(old_tag, new_tag))
+			g_hash_table_insert(diff->changed, old_tag, new_tag);
+		else /* unchanged, keep the tag the row already holds */
+			new_tag = old_tag;
+
+		g_ptr_array_add(diff->tags, tm_tag_ref(new_tag));
+	}
+
+	for (i = 0; i < n_old; i++)
+	{
+		if (! matched[i])
+			g_ptr_array_add(diff->removed, old_tags->pdata[old_start + i]);
+	}
+	g_free(matched);
+}
+
+
+/* Computes the changes between the shown tags and the new tags. Both arrays are
+ * expected to be sorted by name (like TMSourceFile tags); if they aren't, the diff is
+ * still correct but not minimal. */
+static void diff_tree_tags(TagTreeDiff *diff, GPtrArray *old_tags, GPtrArray *new_tags)
+{
+	guint i = 0, j = 0;
+
+	diff->tags = g_ptr_array_sized_new(new_tags->len);
+	diff->added = g_ptr_array_new();
+	diff->removed = g_ptr_array_new();
+	diff->changed = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	while (i < old_tags->len || j < new_tags->len)
 	{
-		TMTag *tag = item->data;
 		const gchar *name;
+		guint i_end = i, j_end = j;
+		gint cmp;
+
+		if (i == old_tags->len)
+			cmp = 1;
+		else if (j == new_tags->len)
+			cmp = -1;
+		else
+			cmp = strcmp(TM_TAG(old_tags->pdata[i])->name, TM_TAG(new_tags->pdata[j])->name);
 
-		tags_table_insert(tags_table, tag, item);
+		name = cmp < 0 ? TM_TAG(old_tags->pdata[i])->name : TM_TAG(new_tags->pdata[j])->name;
+		if (cmp <= 0)
+		{
+			while (i_end < old_tags->len && strcmp(TM_TAG(old_tags->pdata[i_end])->name, name) == 0)
+				i_end++;
+		}
+		if (cmp >= 0)
+		{
+			while (j_end < new_tags->len && strcmp(TM_TAG(new_tags->pdata[j_end])->name, name) == 0)
+				j_end++;
+		}
 
-		name = get_parent_name(tag, doc->file_type->id);
-		if (name)
-			g_hash_table_insert(parents_table, (gpointer) name, NULL);
+		diff_tag_group(diff, old_tags, i, i_end, new_tags, j, j_end);
+		i = i_end;
+		j = j_end;
 	}
+}
+
+
+/* frees the diff except for diff->tags */
+static void tag_tree_diff_free(TagTreeDiff *diff)
+{
+	g_ptr_array_free(diff->added, TRUE);
+	g_ptr_array_free(diff->removed, TRUE);
+	g_hash_table_destroy(diff->changed);
+}
 
-	/* First pass, update existing rows or delete them.
-	 * It is OK to delete them since we walk top down so we would remove
-	 * parents before checking for their children, thus never implicitly
-	 * deleting an updated child */
-	cont = gtk_tree_model_get_iter_first(model, &iter);
+
+/* Forgets the rows below @parent which are about to be removed with it. Rows of tags
+ * which still exist are queued for re-adding. */
+static void orphan_child_rows(GeanyDocument *doc, TagTreeDiff *diff, GHashTable *removed,
+		GtkTreeIter *parent)
+{
+	GtkTreeModel *model = GTK_TREE_MODEL(doc->priv->tag_store);
+	GtkTreeIter iter;
+	gboolean cont;
+
+	cont = gtk_tree_model_iter_children(model, &iter, parent);
 	while (cont)
 	{
 		TMTag *tag;
 
+		orphan_child_rows(doc, diff, removed, &iter);
+
 		gtk_tree_model_get(model, &iter, SYMBOLS_COLUMN_TAG, &tag, -1);
-		if (! tag) /* most probably a toplevel, skip it */
-			cont = ui_tree_model_iter_any_next(model, &iter, TRUE);
-		else
+		if (tag)
 		{
-			GList *found_item;
-
-			found_item = tags_table_lookup(tags_table, tag);
-			if (! found_item) /* tag doesn't exist, remove it */
-				cont = tree_store_remove_row(store, &iter);
-			else /* tag still exist, update it */
+			g_hash_table_remove(doc->priv->tag_tree_iters, tag);
+			if (! g_hash_table_contains(removed, tag))
 			{
-				const gchar *parent_name;
-				TMTag *found = found_item->data;
+				TMTag *new_tag = g_hash_table_lookup(diff->changed, tag);
 
-				parent_name = get_parent_name(found, doc->file_type->id);
-				/* if parent is unknown, ignore it */
-				if (parent_name && ! g_hash_table_lookup(parents_table, parent_name))
-					parent_name = NULL;
+				if (new_tag)
+					g_hash_table_remove(diff->changed, tag);
+				g_ptr_array_add(diff->added, new_tag ? new_tag : tag);
+			}
+			tm_tag_unref(tag);
+		}
+		cont = gtk_tree_model_iter_next(model, &iter);
+	}
+}
 
-				if (!tm_tags_equal(tag, found))
-				{
-					const gchar *name;
-					gchar *tooltip;
-
-					/* only update fields that (can) have changed (name that holds line
-					 * number, tooltip, and the tag itself) */
-					name = get_symbol_name(doc, found, parent_name != NULL);
-					tooltip = get_symbol_tooltip(doc, found);
-					gtk_tree_store_set(store, &iter,
-							SYMBOLS_COLUMN_NAME, name,
-							SYMBOLS_COLUMN_TOOLTIP, tooltip,
-							SYMBOLS_COLUMN_TAG, found,
-							-1);
-					g_free(tooltip);
-				}
 
-				update_parents_table(parents_table, found, parent_name, &iter);
+static void remove_tree_tags(GeanyDocument *doc, TagTreeDiff *diff)
+{
+	GHashTable *removed = g_hash_table_new(g_direct_hash, g_direct_equal);
+	TMTag *tag;
+	guint i;
 
-				/* remove the updated tag from the table and list */
-				tags_table_remove(tags_table, found);
-				*tags = g_list_delete_link(*tags, found_item);
+	foreach_ptr_array(tag, i, diff->removed)
+		g_hash_table_add(removed, tag);
 
-				cont = ui_tree_model_iter_any_next(model, &iter, TRUE);
-			}
+	foreach_ptr_array(tag, i, diff->removed)
+	{
+		GtkTreeIter *row = g_hash_table_lookup(doc->priv->tag_tree_iters, tag);
+		GtkTreeIter iter;
 
-			tm_tag_unref(tag);
-		}
+		if (! row) /* no row, or already removed with its parent */
+			continue;
+
+		iter = *row;
+		orphan_child_rows(doc, diff, removed, &iter);
+		g_hash_table_remove(doc->priv->tag_tree_iters, tag);
+		gtk_tree_store_remove(doc->priv->tag_store, &iter);
+	}
+
+	g_hash_table_destroy(removed);
+}
+
+
+static void update_changed_tree_tags(GeanyDocument *doc, TagTreeDiff *diff)
+{
+	GtkTreeStore *store = doc->priv->tag_store;
+	GHashTableIter hash_iter;
+	gpointer old_tag, new_tag;
+
+	g_hash_table_iter_init(&hash_iter, diff->changed);
+	while (g_hash_table_iter_next(&hash_iter, &old_tag, &new_tag))
+	{
+		GtkTreeIter *row = g_hash_table_lookup(doc->priv->tag_tree_iters, old_tag);
+		GtkTreeIter iter;
+		const gchar *name;
+		gchar *tooltip;
+
+		if (! row)
+			continue;
+
+		iter = *row;
+		/* only update fields that (can) have changed (name that holds line
+		 * number, tooltip, and the tag itself); tags below a parent tag are at depth 2+ */
+		name = get_symbol_name(doc, new_tag, gtk_tree_store_iter_depth(store, &iter) > 1);
+		tooltip = get_symbol_tooltip(doc, new_tag);
+		gtk_tree_store_set(store, &iter,
+				SYMBOLS_COLUMN_NAME, name,
+				SYMBOLS_COLUMN_TOOLTIP, tooltip,
+				SYMBOLS_COLUMN_TAG, new_tag,
+				-1);
+		g_free(tooltip);
+
+		g_hash_table_remove(doc->priv->tag_tree_iters, old_tag);
+		g_hash_table_insert(doc->priv->tag_tree_iters, new_tag, g_slice_dup(GtkTreeIter, &iter));
+	}
+}
+
+
+static gint compare_symbol_lines_ptr(gconstpointer a, gconstpointer b)
+{
+	return compare_symbol_lines(*((TMTag **) a), *((TMTag **) b));
+}
+
+
+static void add_tree_tags(GeanyDocument *doc, TagTreeDiff *diff)
+{
+	GtkTreeStore *store = doc->priv->tag_store;
+	GtkTreeModel *model = GTK_TREE_MODEL(store);
+	GHashTable *parents_table;
+	GHashTableIter hash_iter;
+	gpointer key, value;
+	TMTag *tag;
+	guint i;
+
+	if (diff->added->len == 0)
+		return;
+
+	/* parent table is GHashTable<tag_name, GTree<line_num, GtkTreeIter>> */
+	parents_table = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, parents_table_value_free);
+	foreach_ptr_array(tag, i, diff->tags)
+	{
+		const gchar *name = get_parent_name(tag, doc->file_type->id);
+
+		if (name)
+			g_hash_table_insert(parents_table, (gpointer) name, NULL);
 	}
+	/* existing rows can be parents of the new ones */
+	g_hash_table_iter_init(&hash_iter, doc->priv->tag_tree_iters);
+	while (g_hash_table_iter_next(&hash_iter, &key, &value))
+		update_parents_table(parents_table, key, get_parent_name(key, doc->file_type->id), value);
 
-	/* Second pass, now we have a tree cleaned up from invalid rows,
-	 * we simply add new ones */
-	foreach_list (item, *tags)
+	/* add by line so parents are added before their children */
+	g_ptr_array_sort(diff->added, compare_symbol_lines_ptr);
+	foreach_ptr_array(tag, i, diff->added)
 	{
-		TMTag *tag = item->data;
 		GtkTreeIter *parent;
 
 		parent = get_tag_type_iter(tag->type);
@@ -1401,6 +1506,7 @@ static void update_tree_tags(GeanyDocument *doc, GList **tags)
 			geany_debug("Missing symbol-tree parent iter for type %d!", tag->type);
 		else
 		{
+			GtkTreeIter iter;
 			gboolean expand;
 			const gchar *name;
 			const gchar *parent_name;
@@ -1435,6 +1541,7 @@ static void update_tree_tags(GeanyDocument *doc, GList **tags)
 			if (G_LIKELY(icon))
 				g_object_unref(icon);
 
+			g_hash_table_insert(doc->priv->tag_tree_iters, tag, g_slice_dup(GtkTreeIter, &iter));
 			update_parents_table(parents_table, tag, parent_name, &iter);
 
 			if (expand)
@@ -1443,139 +1550,92 @@ static void update_tree_tags(GeanyDocument *doc, GList **tags)
 	}
 
 	g_hash_table_destroy(parents_table);
-	g_hash_table_destroy(tags_table);
 }
 
 
-/* we don't want to sort 1st-level nodes, but we can't return 0 because the tree sort
- * is not stable, so the order is already lost. */
-static gint compare_top_level_names(const gchar *a, const gchar *b)
+/*
+ * Updates the tag tree for a document with its current tags.
+ * @param doc a document
+ * @param sort_mode the sort mode to use
+ *
+ * The new tags are diffed against the tags shown in the tree, and only the
+ * resulting changes are applied:
+ * 1) rows of tags which don't exist anymore are removed (children which still
+ *    exist are re-added later);
+ * 2) rows of tags which changed (e.g. their line) are updated in place;
+ * 3) rows for new tags are added, looking up their parent in a table holding
+ *    "tag-name":row references for tags having children.
+ * Sorting is disabled while applying the changes and the tree is only re-sorted
+ * if anything changed.
+ */
+static void update_tree_tags(GeanyDocument *doc, gint sort_mode)
 {
-	guint i;
-	const gchar *name;
-
-	/* This should never happen as it would mean that two or more top
-	 * level items have the same name but it can happen by typos in the translations. */
-	if (utils_str_equal(a, b))
-		return 1;
+	GtkTreeStore *store = doc->priv->tag_store;
+	GPtrArray *tags = doc->tm_file->tags_array;
+	TagTreeDiff diff;
+	GTimer *timer = g_timer_new();
+	guint n_added, n_removed, n_changed;
 
-	foreach_ptr_array(name, i, top_level_iter_names)
+	/* tags of another language (e.g. after a filetype change) belong to other groups */
+	if (doc->priv->tag_tree_tags && doc->priv->tag_tree_tags->len > 0 &&
+		TM_TAG(doc->priv->tag_tree_tags->pdata[0])->lang != doc->tm_file->lang)
 	{
-		if (utils_str_equal(name, a))
-			return -1;
-		if (utils_str_equal(name, b))
-			return 1;
+		gtk_tree_store_clear(store);
+		symbols_free_tag_tree_cache(doc);
 	}
-	g_warning("Couldn't find top level node '%s' or '%s'!", a, b);
-	return 0;
-}
-
-
-static gboolean tag_has_missing_parent(const TMTag *tag, GtkTreeStore *store,
-		GtkTreeIter *iter)
-{
-	/* if the tag has a parent tag, it should be at depth >= 2 */
-	return !EMPTY(tag->scope) &&
-		gtk_tree_store_iter_depth(store, iter) == 1;
-}
-
-
-static gint tree_sort_func(GtkTreeModel *model, GtkTreeIter *a, GtkTreeIter *b,
-		gpointer user_data)
-{
-	gboolean sort_by_name = GPOINTER_TO_INT(user_data);
-	TMTag *tag_a, *tag_b;
-	gint cmp;
-
-	gtk_tree_model_get(model, a, SYMBOLS_COLUMN_TAG, &tag_a, -1);
-	gtk_tree_model_get(model, b, SYMBOLS_COLUMN_TAG, &tag_b, -1);
-
-	/* Check if the iters can be sorted based on tag name and line, not tree item name.
-	 * Sort by tree name if the scope was prepended, e.g. 'ScopeNameWithNoTag::TagName'. */
-	if (tag_a && !tag_has_missing_parent(tag_a, GTK_TREE_STORE(model), a) &&
-		tag_b && !tag_has_missing_parent(tag_b, GTK_TREE_STORE(model), b))
+	if (! doc->priv->tag_tree_tags)
 	{
-		cmp = sort_by_name ? compare_symbol(tag_a, tag_b) :
-			compare_symbol_lines(tag_a, tag_b);
+		doc->priv->tag_tree_tags = g_ptr_array_new();
+		/* GtkTreeStore iters persist, so the row of each tag can be kept */
+		doc->priv->tag_tree_iters = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+			NULL, parents_table_tree_value_free);
 	}
-	else
-	{
-		gchar *astr, *bstr;
 
-		gtk_tree_model_get(model, a, SYMBOLS_COLUMN_NAME, &astr, -1);
-		gtk_tree_model_get(model, b, SYMBOLS_COLUMN_NAME, &bstr, -1);
+	diff_tree_tags(&diff, doc->priv->tag_tree_tags, tags);
+	n_added = diff.added->len;
+	n_removed = diff.removed->len;
+	n_changed = g_hash_table_size(diff.changed);
 
-		/* if a is toplevel, b must be also */
-		if (gtk_tree_store_iter_depth(GTK_TREE_STORE(model), a) == 0)
-		{
-			cmp = compare_top_level_names(astr, bstr);
-		}
-		else
-		{
-			/* this is what g_strcmp0() does */
-			if (! astr)
-				cmp = -(astr != bstr);
-			else if (! bstr)
-				cmp = astr != bstr;
-			else
-			{
-				cmp = strcmp(astr, bstr);
+	if (n_added > 0 || n_removed > 0 || n_changed > 0 ||
+		sort_mode != doc->priv->symbol_list_sort_mode)
+	{
+		/* disable sorting during update because the code doesn't support correctly
+		 * models that are currently being built */
+		gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(store), GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID, 0);
 
-				/* sort duplicate 'ScopeName::OverloadedTagName' items by line as well */
-				if (tag_a && tag_b)
-					if (!sort_by_name ||
-						(utils_str_equal(tag_a->name, tag_b->name) &&
-							utils_str_equal(tag_a->scope, tag_b->scope)))
-						cmp = compare_symbol_lines(tag_a, tag_b);
-			}
-		}
-		g_free(astr);
-		g_free(bstr);
-	}
-	tm_tag_unref(tag_a);
-	tm_tag_unref(tag_b);
+		/* add grandparent type iters */
+		add_top_level_items(doc);
 
-	return cmp;
-}
+		remove_tree_tags(doc, &diff);
+		update_changed_tree_tags(doc, &diff);
+		add_tree_tags(doc, &diff);
 
+		hide_empty_rows(store);
+		sort_tree(store, sort_mode == SYMBOLS_SORT_BY_NAME);
 
-static void sort_tree(GtkTreeStore *store, gboolean sort_by_name)
-{
-	gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(store), SYMBOLS_COLUMN_NAME, tree_sort_func,
-		GINT_TO_POINTER(sort_by_name), NULL);
+		geany_debug("Symbol tree of %s updated in %.3f ms (%u tags: %u added, %u removed, %u changed)",
+			DOC_FILENAME(doc), g_timer_elapsed(timer, NULL) * 1000.0, tags->len,
+			n_added, n_removed, n_changed);
+	}
 
-	gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(store), SYMBOLS_COLUMN_NAME, GTK_SORT_ASCENDING);
+	tm_tags_array_free(doc->priv->tag_tree_tags, TRUE);
+	doc->priv->tag_tree_tags = diff.tags;
+	tag_tree_diff_free(&diff);
+	g_timer_destroy(timer);
 }
 
 
 gboolean symbols_recreate_tag_list(GeanyDocument *doc, gint sort_mode)
 {
-	GList *tags;
-
 	g_return_val_if_fail(DOC_VALID(doc), FALSE);
 
-	tags = get_tag_list(doc, tm_tag_max_t);
-	if (tags == NULL)
+	if (! doc->tm_file || ! doc->tm_file->tags_array || doc->tm_file->tags_array->len == 0)
 		return FALSE;
 
-	/* FIXME: Not sure why we detached the model here? */
-
-	/* disable sorting during update because the code doesn't support correctly
-	 * models that are currently being built */
-	gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(doc->priv->tag_store), GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID, 0);
-
-	/* add grandparent type iters */
-	add_top_level_items(doc);
-
-	update_tree_tags(doc, &tags);
-	g_list_free(tags);
-
-	hide_empty_rows(doc->priv->tag_store);
-
 	if (sort_mode == SYMBOLS_SORT_USE_PREVIOUS)
 		sort_mode = doc->priv->symbol_list_sort_mode;
 
-	sort_tree(doc->priv->tag_store, sort_mode == SYMBOLS_SORT_BY_NAME);
+	update_tree_tags(doc, sort_mode);
 	doc->priv->symbol_list_sort_mode = sort_mode;
 
 	return TRUE;
@@ -1617,6 +1677,7 @@ int symbols_generate_global_tags(int argc, char **argv, gboolean want_preprocess
 		/* Create global taglist */
 		int status;
 		char *command;
+		gchar *cache_dir;
 		const char *tags_file = argv[1];
 		char *utf8_fname;
 		GeanyFiletype *ft;
@@ -1645,11 +1706,17 @@ int symbols_generate_global_tags(int argc, char **argv, gboolean want_preprocess
 		else
 			command = NULL;	/* don't preprocess */
 
+		/* the tags of batches which preprocess to the same output are reused */
+		cache_dir = g_build_filename(g_get_user_cache_dir(), "geany", "tags", NULL);
+		if (utils_mkdir(cache_dir, TRUE) != 0)
+			SETPTR(cache_dir, NULL);
+
 		geany_debug("Generating %s tags file.", ft->name);
 		tm_get_workspace();
 		status = tm_workspace_create_global_tags(command, (const char **) (argv + 2),
-												 argc - 2, tags_file, ft->lang);
+												 argc - 2, tags_file, ft->lang, cache_dir);
 		g_free(command);
+		g_free(cache_dir);
 		symbols_finalize(); /* free c_tags_ignore data */
 		if (! status)
 		{
@@ -1758,6 +1825,74 @@ static void init_user_tags(void)
 }
 
 
+/* Updates the type keywords of the documents using the global tags of ft */
+static void update_global_typenames(GeanyFiletype *ft)
+{
+	guint i;
+
+	foreach_document(i)
+	{
+		GeanyFiletypeID id = documents[i]->file_type->id;
+
+		/* C++ and PHP documents use the C and HTML global tags, too */
+		if (id == ft->id ||
+			(ft->id == GEANY_FILETYPES_C && id == GEANY_FILETYPES_CPP) ||
+			(ft->id == GEANY_FILETYPES_HTML && id == GEANY_FILETYPES_PHP))
+		{
+			highlighting_set_styles(documents[i]->editor->sci, documents[i]->file_type);
+		}
+	}
+}
+
+
+/* Adds the tags read by read_global_tags() to the workspace in the main thread */
+static gboolean on_global_tags_read(gpointer data)
+{
+	GlobalTagsJob *job = data;
+
+	if (global_tags_pool == NULL)
+	{
+		/* shutting down, the workspace may be gone */
+		tm_tags_array_free(job->tags, TRUE);
+	}
+	else if (job->tags)
+	{
+		gsize old_tag_count = get_tag_count();
+
+		tm_workspace_add_global_tags(job->tags);
+		geany_debug("Loaded %s (%s), %u symbol(s).", job->file_name, job->ft->name,
+			(guint) (get_tag_count() - old_tag_count));
+	}
+	else
+	{
+		gchar *utf8_fname = utils_get_utf8_from_locale(job->file_name);
+
+		msgwin_status_add(_("Could not load tags file '%s'."), utf8_fname);
+		g_free(utf8_fname);
+	}
+
+	if (global_tags_pool != NULL && --global_tags_pending[job->ft->id] == 0)
+	{
+		msgwin_status_add(_("Loaded %s tags files."), filetypes_get_display_name(job->ft));
+		update_global_typenames(job->ft);
+	}
+
+	g_free(job->file_name);
+	g_free(job);
+	return FALSE;
+}
+
+
+/* Runs in the thread of global_tags_pool */
+static void read_global_tags(gpointer data, gpointer user_data)
+{
+	GlobalTagsJob *job = data;
+
+	job->tags = tm_workspace_read_global_tags(job->file_name, job->ft->lang);
+	g_idle_add(on_global_tags_read, job);
+}
+
+
 static void load_user_tags(GeanyFiletypeID ft_id)
 {
 	static guchar *tags_loaded = NULL;
@@ -1779,11 +1914,26 @@ static void load_user_tags(GeanyFiletypeID ft_id)
 		init_tags = TRUE;
 	}
 
+	if (ft->priv->tag_files == NULL)
+		return;
+
+	/* read the files in the background, until they are added completion just
+	 * doesn't know their symbols yet */
+	if (!global_tags_pool)
+	{
+		global_tags_pool = g_thread_pool_new(read_global_tags, NULL, 1, FALSE, NULL);
+		global_tags_pending = g_new0(guint, filetypes_array->len);
+	}
+	msgwin_status_add(_("Loading %s tags files..."), filetypes_get_display_name(ft));
+
 	for (node = ft->priv->tag_files; node != NULL; node = g_slist_next(node))
 	{
-		const gchar *fname = node->data;
+		GlobalTagsJob *job = g_new0(GlobalTagsJob, 1);
 
-		symbols_load_global_tags(fname, ft);
+		job->file_name = g_strdup(node->data);
+		job->ft = ft;
+		global_tags_pending[ft_id]++;
+		g_thread_pool_push(global_tags_pool, job, NULL);
 	}
 }
 
@@ -2338,7 +2488,7 @@ static gint get_current_tag_name(GeanyDocument *doc, gchar **tagname, TMTagType
 	if (parent >= 0 && doc->tm_file != NULL && doc->tm_file->tags_array != NULL &&
 		(! doc->changed || editor_prefs.autocompletion_update_freq > 0))
 	{
-		const TMTag *tag = tm_get_current_tag(doc->tm_file->tags_array, parent + 1, tag_types);
+		const TMTag *tag = tm_source_file_get_current_tag(doc->tm_file, parent + 1, tag_types);
 
 		if (tag)
 		{
@@ -2644,6 +2794,14 @@ void symbols_finalize(void)
 {
 	guint i;
 
+	if (global_tags_pool)
+	{
+		/* skip the files not read yet and wait for the one being read */
+		g_thread_pool_free(global_tags_pool, TRUE, TRUE);
+		global_tags_pool = NULL;
+		g_free(global_tags_pending);
+		global_tags_pending = NULL;
+	}
 	g_strfreev(c_tags_ignore);
 
 	for (i = 0; i < G_N_ELEMENTS(symbols_icons); i++)
@@ -54,6 +54,8 @@ GString *symbols_find_typenames_as_string(TMParserType lang, gboolean global);
 
 gboolean symbols_recreate_tag_list(GeanyDocument *doc, gint sort_mode);
 
+void symbols_free_tag_tree_cache(GeanyDocument *doc);
+
 gint symbols_generate_global_tags(gint argc, gchar **argv, gboolean want_preprocess);
 
 void symbols_show_load_tags_dialog(void);
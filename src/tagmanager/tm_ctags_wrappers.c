@@ -24,6 +24,7 @@
 #include "entry.h"
 #include "parse.h"
 #include "read.h"
+#include "options.h"
 
 
 typedef struct {
@@ -169,3 +170,10 @@ guint tm_ctags_get_lang_count(void)
 {
 	return LanguageCount;
 }
+
+
+/* The NULL-terminated list of tokens the C-like parsers ignore, NULL if none */
+const gchar *const *tm_ctags_get_ignore_tags(void)
+{
+	return (const gchar *const *) c_tags_ignore;
+}
@@ -60,6 +60,8 @@ gboolean tm_ctags_is_using_regex_parser(TMParserType lang);
 
 guint tm_ctags_get_lang_count(void);
 
+const gchar *const *tm_ctags_get_ignore_tags(void);
+
 G_END_DECLS
 
 #endif /* TM_CTAGS_WRAPPERS */
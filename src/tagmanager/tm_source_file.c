@@ -32,12 +32,29 @@
 #include "tm_parser.h"
 #include "tm_ctags_wrappers.h"
 
+/* number of tag types, i.e. bits in tm_tag_max_t */
+#define TAG_TYPE_COUNT g_bit_storage(tm_tag_max_t)
+
+/* tm_tag_max_t has all the tag type bits set */
+G_STATIC_ASSERT((tm_tag_max_t & (tm_tag_max_t + 1)) == 0);
+
+/* Index for finding the tag "owning" a line in O(log n) */
+typedef struct
+{
+	GPtrArray **type_tags;	/* tags of each type sorted by line, TAG_TYPE_COUNT entries */
+} TMScopeIndex;
+
 typedef struct
 {
 	TMSourceFile public;
 	guint refcount;
+	TMScopeIndex *scope_index; /* built on demand, NULL when the tags changed */
+	GHashTable *occurrences; /* token -> GArray of lines, NULL when not indexed */
 } TMSourceFilePriv;
 
+/* only ASCII, non-ASCII bytes may be punctuation ending a word, e.g. in «foo» */
+#define IS_TOKEN_CHAR(c) (g_ascii_isalnum(c) || (c) == '_')
+
 
 typedef enum {
 	TM_FILE_FORMAT_TAGMANAGER,
@@ -630,11 +647,246 @@ static void update_python_arglist(const TMTag *tag, TMSourceFile *current_source
 	}
 }
 
+static void scope_index_free(TMScopeIndex *index)
+{
+	guint i;
+
+	for (i = 0; i < TAG_TYPE_COUNT; i++)
+	{
+		if (index->type_tags[i])
+			g_ptr_array_free(index->type_tags[i], TRUE);
+	}
+	g_free(index->type_tags);
+	g_slice_free(TMScopeIndex, index);
+}
+
+
+/* must be called before the tags of the source file are freed */
+static void invalidate_scope_index(TMSourceFile *source_file)
+{
+	TMSourceFilePriv *priv = (TMSourceFilePriv *) source_file;
+
+	if (priv->scope_index)
+	{
+		scope_index_free(priv->scope_index);
+		priv->scope_index = NULL;
+	}
+}
+
+
+/* sort by line, keeping the original order of tags on the same line */
+static gint tag_line_compare(gconstpointer ptr1, gconstpointer ptr2)
+{
+	const TMTag *t1 = *((const TMTag **) ptr1);
+	const TMTag *t2 = *((const TMTag **) ptr2);
+
+	return (t1->line > t2->line) - (t1->line < t2->line);
+}
+
+
+static TMScopeIndex *scope_index_new(TMSourceFile *source_file)
+{
+	TMScopeIndex *index = g_slice_new0(TMScopeIndex);
+	GPtrArray *tags;
+	guint i;
+
+	index->type_tags = g_new0(GPtrArray *, TAG_TYPE_COUNT);
+	tags = g_ptr_array_sized_new(source_file->tags_array->len);
+	for (i = 0; i < source_file->tags_array->len; i++)
+		g_ptr_array_add(tags, source_file->tags_array->pdata[i]);
+	g_ptr_array_sort(tags, tag_line_compare);
+
+	for (i = 0; i < tags->len; i++)
+	{
+		TMTag *tag = tags->pdata[i];
+		gint type_bit = g_bit_nth_lsf(tag->type, -1);
+
+		if (type_bit >= 0 && (guint) type_bit < TAG_TYPE_COUNT)
+		{
+			if (!index->type_tags[type_bit])
+				index->type_tags[type_bit] = g_ptr_array_new();
+			g_ptr_array_add(index->type_tags[type_bit], tag);
+		}
+	}
+
+	g_ptr_array_free(tags, TRUE);
+	return index;
+}
+
+
+static TMScopeIndex *get_scope_index(TMSourceFile *source_file)
+{
+	TMSourceFilePriv *priv = (TMSourceFilePriv *) source_file;
+
+	if (!priv->scope_index)
+		priv->scope_index = scope_index_new(source_file);
+	return priv->scope_index;
+}
+
+
+/* Returns the first tag on the last line <= line in tags sorted by line */
+static TMTag *find_tag_before_line(const GPtrArray *tags, gulong line)
+{
+	guint l = 0, u = tags->len;
+	gulong found_line;
+
+	/* first tag after line */
+	while (l < u)
+	{
+		guint idx = (l + u) / 2;
+
+		if (TM_TAG(tags->pdata[idx])->line <= line)
+			l = idx + 1;
+		else
+			u = idx;
+	}
+	if (l == 0)
+		return NULL;
+
+	/* first tag on the line of the preceding one */
+	found_line = TM_TAG(tags->pdata[l - 1])->line;
+	u = l - 1;
+	l = 0;
+	while (l < u)
+	{
+		guint idx = (l + u) / 2;
+
+		if (TM_TAG(tags->pdata[idx])->line < found_line)
+			l = idx + 1;
+		else
+			u = idx;
+	}
+	return tags->pdata[l];
+}
+
+
+/* Returns the tag "owning" the given line, i.e. the nearest tag of the given types
+ defined on or before the line. Like tm_get_current_tag() but O(log n).
+ @param source_file The source file.
+ @param line Line in the source file.
+ @param tag_types The tag types to include in the match.
+ @return The matching tag or NULL. */
+const TMTag *tm_source_file_get_current_tag(TMSourceFile *source_file, gulong line,
+	TMTagType tag_types)
+{
+	TMScopeIndex *index;
+	const TMTag *matching_tag = NULL;
+	guint i;
+
+	g_return_val_if_fail(source_file != NULL, NULL);
+
+	if (!source_file->tags_array || source_file->tags_array->len == 0)
+		return NULL;
+
+	index = get_scope_index(source_file);
+	for (i = 0; i < TAG_TYPE_COUNT; i++)
+	{
+		const TMTag *tag;
+
+		if (!(tag_types & (1 << i)) || !index->type_tags[i])
+			continue;
+
+		tag = find_tag_before_line(index->type_tags[i], line);
+		/* on the same line prefer the tag sorted first in the tags array */
+		if (tag && tag->line > 0 &&
+			(!matching_tag || tag->line > matching_tag->line ||
+			 (tag->line == matching_tag->line && strcmp(tag->name, matching_tag->name) < 0)))
+		{
+			matching_tag = tag;
+		}
+	}
+	return matching_tag;
+}
+
+
+/* Records the lines on which each identifier-like token of the buffer appears */
+static GHashTable *occurrence_index_new(const guchar *buf, gsize buf_size)
+{
+	GHashTable *index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+		(GDestroyNotify) g_array_unref);
+	GString *token = g_string_sized_new(64);
+	guint line = 1;
+	gsize i = 0;
+
+	while (i < buf_size)
+	{
+		if (IS_TOKEN_CHAR(buf[i]))
+		{
+			GArray *lines;
+
+			g_string_truncate(token, 0);
+			while (i < buf_size && IS_TOKEN_CHAR(buf[i]))
+				g_string_append_c(token, buf[i++]);
+
+			lines = g_hash_table_lookup(index, token->str);
+			if (!lines)
+			{
+				lines = g_array_new(FALSE, FALSE, sizeof(guint));
+				g_hash_table_insert(index, g_strndup(token->str, token->len), lines);
+			}
+			if (lines->len == 0 || g_array_index(lines, guint, lines->len - 1) != line)
+				g_array_append_val(lines, line);
+		}
+		else
+		{
+			if (buf[i] == '\n')
+				line++;
+			i++;
+		}
+	}
+
+	g_string_free(token, TRUE);
+	return index;
+}
+
+
+static void set_occurrence_index(TMSourceFile *source_file, GHashTable *index)
+{
+	TMSourceFilePriv *priv = (TMSourceFilePriv *) source_file;
+
+	if (priv->occurrences)
+		g_hash_table_destroy(priv->occurrences);
+	priv->occurrences = index;
+}
+
+
+/* Checks whether the occurrences of tokens in the source file are known, i.e.
+ whether tm_source_file_get_occurrences() can be trusted. Only files last parsed from
+ disk and small enough to be parsed from memory are indexed, not parsed buffers.
+ @param source_file The source file.
+ @return TRUE if the source file is indexed. */
+gboolean tm_source_file_has_occurrence_index(TMSourceFile *source_file)
+{
+	g_return_val_if_fail(source_file != NULL, FALSE);
+
+	return ((TMSourceFilePriv *) source_file)->occurrences != NULL;
+}
+
+
+/* Gets the lines on which a token appears in the source file at the time of the last
+ parse. Tokens are maximal runs of ASCII alphanumeric characters and underscores.
+ @param source_file The source file.
+ @param token The token to look for.
+ @return Sorted array of 1-based guint line numbers owned by the source file, or NULL
+ if the token doesn't appear in the file or the file isn't indexed. */
+GArray *tm_source_file_get_occurrences(TMSourceFile *source_file, const gchar *token)
+{
+	TMSourceFilePriv *priv = (TMSourceFilePriv *) source_file;
+
+	g_return_val_if_fail(source_file != NULL && token != NULL, NULL);
+
+	if (!priv->occurrences)
+		return NULL;
+	return g_hash_table_lookup(priv->occurrences, token);
+}
+
+
 /* new parsing pass ctags callback function */
 static gboolean ctags_pass_start(void *user_data)
 {
 	TMSourceFile *current_source_file = user_data;
 
+	invalidate_scope_index(current_source_file);
 	tm_tags_array_free(current_source_file->tags_array, FALSE);
 	return TRUE;
 }
@@ -720,6 +972,8 @@ TMSourceFile *tm_source_file_new(const char *file_name, const char *name)
 		return NULL;
 	}
 	priv->refcount = 1;
+	priv->scope_index = NULL;
+	priv->occurrences = NULL;
 	return &priv->public;
 }
 
@@ -745,6 +999,8 @@ static void tm_source_file_destroy(TMSourceFile *source_file)
 #endif
 
 	g_free(source_file->file_name);
+	invalidate_scope_index(source_file);
+	set_occurrence_index(source_file, NULL);
 	tm_tags_array_free(source_file->tags_array, TRUE);
 	source_file->tags_array = NULL;
 }
@@ -798,10 +1054,14 @@ gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize
 		g_warning("Attempt to parse NULL file");
 		return FALSE;
 	}
+
+	/* the tags are going to be freed */
+	invalidate_scope_index(source_file);
 	
 	if (source_file->lang == TM_PARSER_NONE)
 	{
 		tm_tags_array_free(source_file->tags_array, FALSE);
+		set_occurrence_index(source_file, NULL);
 		return FALSE;
 	}
 	
@@ -811,7 +1071,9 @@ gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize
 	{
 		GStatBuf s;
 		
-		/* load file to memory and parse it from memory unless the file is too big */
+		/* load file to memory and parse it from memory unless the file is too big;
+		 * the file isn't mapped as another process truncating it during the parse
+		 * would crash Geany with SIGBUS */
 		if (g_stat(file_name, &s) != 0 || s.st_size > 10*1024*1024)
 			parse_file = TRUE;
 		else
@@ -829,6 +1091,7 @@ gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize
 	{
 		/* Empty buffer, "parse" by setting empty tag array */
 		tm_tags_array_free(source_file->tags_array, FALSE);
+		set_occurrence_index(source_file, use_buffer ? NULL : occurrence_index_new(NULL, 0));
 		if (free_buf)
 			g_free(text_buf);
 		return TRUE;
@@ -839,6 +1102,12 @@ gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize
 	tm_ctags_parse(parse_file ? NULL : text_buf, buf_size, file_name,
 		source_file->lang, ctags_new_tag, ctags_pass_start, source_file);
 
+	/* index the tokens of files read from disk, too big files read by ctags aren't;
+	 * neither are the buffers of open documents, which are reparsed as they are
+	 * edited and searched by the editor instead */
+	set_occurrence_index(source_file, (parse_file || use_buffer) ? NULL :
+		occurrence_index_new(text_buf, buf_size));
+
 	if (free_buf)
 		g_free(text_buf);
 	return !retry;
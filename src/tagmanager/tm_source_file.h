@@ -57,6 +57,13 @@ GPtrArray *tm_source_file_read_tags_file(const gchar *tags_file, TMParserType mo
 
 gboolean tm_source_file_write_tags_file(const gchar *tags_file, GPtrArray *tags_array);
 
+const struct TMTag *tm_source_file_get_current_tag(TMSourceFile *source_file, gulong line,
+	TMTagType tag_types);
+
+gboolean tm_source_file_has_occurrence_index(TMSourceFile *source_file);
+
+GArray *tm_source_file_get_occurrences(TMSourceFile *source_file, const gchar *token);
+
 #endif /* GEANY_PRIVATE */
 
 G_END_DECLS
@@ -78,8 +78,6 @@ typedef struct
 {
 	guint *sort_attrs;
 	gboolean partial;
-	const GPtrArray *tags_array;
-	gboolean first;
 } TMSortOptions;
 
 /* Gets the GType for a TMTag */
@@ -486,6 +484,100 @@ GPtrArray *tm_tags_merge(GPtrArray *big_array, GPtrArray *small_array,
 	return res_array;
 }
 
+typedef struct
+{
+	GPtrArray *tags;
+	guint pos;
+} MergeHead;
+
+static gint merge_head_compare(MergeHead *head1, MergeHead *head2, TMSortOptions *sort_options)
+{
+	return tm_tag_compare(&head1->tags->pdata[head1->pos], &head2->tags->pdata[head2->pos],
+		sort_options);
+}
+
+static void merge_heap_sift_down(MergeHead *heap, guint len, guint i, TMSortOptions *sort_options)
+{
+	while (TRUE)
+	{
+		guint smallest = i;
+		guint left = 2 * i + 1;
+		guint right = left + 1;
+		MergeHead tmp;
+
+		if (left < len && merge_head_compare(&heap[left], &heap[smallest], sort_options) < 0)
+			smallest = left;
+		if (right < len && merge_head_compare(&heap[right], &heap[smallest], sort_options) < 0)
+			smallest = right;
+		if (smallest == i)
+			break;
+
+		tmp = heap[i];
+		heap[i] = heap[smallest];
+		heap[smallest] = tmp;
+		i = smallest;
+	}
+}
+
+/*
+ Merges several arrays of tags sorted on the same attributes into a new sorted array.
+ Uses a heap of the heads of the arrays so merging n tags from k arrays is O(n log k)
+ instead of sorting all the tags again. The arrays must not contain tags comparing
+ equal, the result is not deduplicated.
+ @param arrays Array of the GPtrArrays of tags to merge.
+ @param sort_attributes Attributes the arrays are sorted on (int array terminated by 0)
+ @return The merged array. Free with g_ptr_array_free(), the tags aren't referenced.
+*/
+GPtrArray *tm_tags_merge_sorted(GPtrArray *arrays, TMTagAttrType *sort_attributes)
+{
+	TMSortOptions sort_options;
+	GPtrArray *res_array;
+	MergeHead *heap;
+	guint i, len = 0, total = 0;
+
+	g_return_val_if_fail(arrays, NULL);
+
+	sort_options.sort_attrs = sort_attributes;
+	sort_options.partial = FALSE;
+
+	heap = g_new(MergeHead, arrays->len + 1);
+	for (i = 0; i < arrays->len; i++)
+	{
+		GPtrArray *tags = arrays->pdata[i];
+
+		if (tags && tags->len > 0)
+		{
+			heap[len].tags = tags;
+			heap[len].pos = 0;
+			len++;
+			total += tags->len;
+		}
+	}
+
+	res_array = g_ptr_array_sized_new(total);
+	for (i = len / 2; i-- > 0;)
+		merge_heap_sift_down(heap, len, i, &sort_options);
+
+	while (len > 1)
+	{
+		MergeHead *head = &heap[0];
+
+		g_ptr_array_add(res_array, head->tags->pdata[head->pos++]);
+		if (head->pos == head->tags->len)
+			heap[0] = heap[--len];
+		merge_heap_sift_down(heap, len, 0, &sort_options);
+	}
+	/* copy the rest of the last array */
+	if (len == 1)
+	{
+		for (i = heap[0].pos; i < heap[0].tags->len; i++)
+			g_ptr_array_add(res_array, heap[0].tags->pdata[i]);
+	}
+
+	g_free(heap);
+	return res_array;
+}
+
 /*
  This function will extract the tags of the specified types from an array of tags.
  The returned value is a GPtrArray which should be free-d with a call to
@@ -535,56 +627,13 @@ void tm_tags_array_free(GPtrArray *tags_array, gboolean free_all)
 	}
 }
 
-/* copy/pasted bsearch() from libc extended with user_data for comparison function
- * and using glib types */
-static gpointer binary_search(gpointer key, gpointer base, size_t nmemb, 
-	GCompareDataFunc compar, gpointer user_data)
+/* Compares name to the name of tag like tm_tag_compare() without sort
+ * attributes, when partial only the first len characters */
+static gint tag_name_cmp(const gchar *name, gsize len, const TMTag *tag, gboolean partial)
 {
-	gsize l, u, idx;
-	gpointer p;
-	gint comparison;
-
-	l = 0;
-	u = nmemb;
-	while (l < u)
-	{
-		idx = (l + u) / 2;
-		p = (gpointer) (((const gchar *) base) + (idx * sizeof(gpointer)));
-		comparison = (*compar) (key, p, user_data);
-		if (comparison < 0)
-			u = idx;
-		else if (comparison > 0)
-			l = idx + 1;
-		else
-			return (gpointer) p;
-	}
-
-	return NULL;
-}
-
-static gint tag_search_cmp(gconstpointer ptr1, gconstpointer ptr2, gpointer user_data)
-{
-	gint res = tm_tag_compare(ptr1, ptr2, user_data);
-
-	if (res == 0)
-	{
-		TMSortOptions *sort_options = user_data;
-		const GPtrArray *tags_array = sort_options->tags_array;
-		TMTag **tag = (TMTag **) ptr2;
-
-		/* if previous/next (depending on sort options) tag equal, we haven't
-		 * found the first/last tag in a sequence of equal tags yet */
-		if (sort_options->first && ptr2 != &tags_array->pdata[0]) {
-			if (tm_tag_compare(ptr1, tag - 1, user_data) == 0)
-				return -1;
-		}
-		else if (!sort_options->first && ptr2 != &tags_array->pdata[tags_array->len-1])
-		{
-			if (tm_tag_compare(ptr1, tag + 1, user_data) == 0)
-				return 1;
-		}
-	}
-	return res;
+	if (partial)
+		return strncmp(name, FALLBACK(tag->name, ""), len);
+	return strcmp(name, FALLBACK(tag->name, ""));
 }
 
 /*
@@ -598,38 +647,47 @@ static gint tag_search_cmp(gconstpointer ptr1, gconstpointer ptr2, gpointer user
 TMTag **tm_tags_find(const GPtrArray *tags_array, const char *name,
 		gboolean partial, guint *tagCount)
 {
-	TMTag *tag, **first;
-	TMSortOptions sort_options;
+	TMTag **tags;
+	gsize len, l, u, first;
 
 	*tagCount = 0;
 	if (!tags_array || !tags_array->len)
 		return NULL;
 
-	tag = g_new0(TMTag, 1);
-	tag->name = (char *) name;
+	tags = (TMTag **) tags_array->pdata;
+	name = FALLBACK(name, "");
+	len = strlen(name);
 
-	sort_options.sort_attrs = NULL;
-	sort_options.partial = partial;
-	sort_options.tags_array = tags_array;
-	sort_options.first = TRUE;
-	first = (TMTag **)binary_search(&tag, tags_array->pdata, tags_array->len,
-			tag_search_cmp, &sort_options);
+	/* the first tag not sorting before name */
+	l = 0;
+	u = tags_array->len;
+	while (l < u)
+	{
+		gsize idx = l + (u - l) / 2;
 
-	if (first)
+		if (tag_name_cmp(name, len, tags[idx], partial) > 0)
+			l = idx + 1;
+		else
+			u = idx;
+	}
+	if (l == tags_array->len || tag_name_cmp(name, len, tags[l], partial) != 0)
+		return NULL;
+	first = l;
+
+	/* the first tag sorting after name */
+	u = tags_array->len;
+	while (l < u)
 	{
-		TMTag **last;
-		unsigned first_pos;
-
-		sort_options.first = FALSE;
-		first_pos = first - (TMTag **)tags_array->pdata;
-		/* search between the first element and end */
-		last = (TMTag **)binary_search(&tag, first, tags_array->len - first_pos,
-				tag_search_cmp, &sort_options);
-		*tagCount = last - first + 1;
+		gsize idx = l + (u - l) / 2;
+
+		if (tag_name_cmp(name, len, tags[idx], partial) >= 0)
+			l = idx + 1;
+		else
+			u = idx;
 	}
 
-	g_free(tag);
-	return (TMTag **) first;
+	*tagCount = l - first;
+	return tags + first;
 }
 
 /* Returns TMTag which "own" given line
@@ -118,6 +118,8 @@ void tm_tags_remove_file_tags(TMSourceFile *source_file, GPtrArray *tags_array);
 GPtrArray *tm_tags_merge(GPtrArray *big_array, GPtrArray *small_array, 
 	TMTagAttrType *sort_attributes, gboolean unref_duplicates);
 
+GPtrArray *tm_tags_merge_sorted(GPtrArray *arrays, TMTagAttrType *sort_attributes);
+
 void tm_tags_sort(GPtrArray *tags_array, TMTagAttrType *sort_attributes,
 	gboolean dedup, gboolean unref_duplicates);
 
@@ -29,6 +29,9 @@
 # include <glob.h>
 #endif
 #include <glib/gstdio.h>
+#ifndef G_OS_WIN32
+# include <sys/wait.h>
+#endif
 
 #include "tm_workspace.h"
 #include "tm_ctags_wrappers.h"
@@ -65,8 +68,295 @@ static TMTagType TM_GLOBAL_TYPE_MASK =
 	tm_tag_class_t | tm_tag_enum_t | tm_tag_interface_t |
 	tm_tag_struct_t | tm_tag_typedef_t | tm_tag_union_t | tm_tag_namespace_t;
 
+/* number of include files preprocessed and parsed together when creating
+ * global tags */
+#define GLOBAL_TAGS_BATCH_SIZE 16
+
+/* seconds after which unused tags of batches are removed from the cache */
+#define GLOBAL_TAGS_CACHE_MAX_AGE (30 * 24 * 60 * 60)
+
 static TMWorkspace *theWorkspace = NULL;
 
+/* Lookup tables of theWorkspace->tags_array and theWorkspace->global_tags */
+typedef struct
+{
+	/* scope -> tags with this scope, in the same order as in the array */
+	GHashTable *scopes;
+	/* type tag -> NULL-terminated names of the types it inherits from */
+	GHashTable *parents;
+} TagIndex;
+
+static TagIndex workspace_index = {NULL, NULL};
+static TagIndex global_index = {NULL, NULL};
+
+/* The tags of theWorkspace->global_tags and global_typename_array split by
+ * language, in the same order, so lookups only search compatible languages */
+static GPtrArray *global_lang_tags[TM_PARSER_COUNT];
+static GPtrArray *global_lang_typenames[TM_PARSER_COUNT];
+
+
+static void tag_index_init(TagIndex *index)
+{
+	index->scopes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+		(GDestroyNotify) g_ptr_array_unref);
+	index->parents = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+		(GDestroyNotify) g_strfreev);
+}
+
+
+static void tag_index_free(TagIndex *index)
+{
+	g_hash_table_destroy(index->scopes);
+	g_hash_table_destroy(index->parents);
+	index->scopes = NULL;
+	index->parents = NULL;
+}
+
+
+static void tag_index_clear(TagIndex *index)
+{
+	g_hash_table_remove_all(index->scopes);
+	g_hash_table_remove_all(index->parents);
+}
+
+
+/* Splits the inheritance of a tag into the names of the parent types, without
+ * template arguments or keywords like "public" and "virtual" */
+static gchar **split_inheritance(const gchar *inheritance)
+{
+	GPtrArray *names = g_ptr_array_new();
+	GString *name = g_string_new(NULL);
+	const gchar *p;
+	gint depth = 0;
+
+	for (p = inheritance; ; p++)
+	{
+		if (*p == '<')
+			depth++;
+		else if (*p == '>')
+			depth--;
+		else if (depth == 0 && (*p == ',' || *p == '\0'))
+		{
+			const gchar *last_word;
+
+			g_strstrip(name->str);
+			last_word = strrchr(name->str, ' ');
+			last_word = last_word ? last_word + 1 : name->str;
+			if (*last_word)
+				g_ptr_array_add(names, g_strdup(last_word));
+			g_string_truncate(name, 0);
+			if (*p == '\0')
+				break;
+		}
+		else if (depth == 0)
+			g_string_append_c(name, *p);
+	}
+	g_string_free(name, TRUE);
+	g_ptr_array_add(names, NULL);
+	return (gchar **) g_ptr_array_free(names, FALSE);
+}
+
+
+/* Adds tags sorted on sort_attrs to an index of tags sorted the same way */
+static void tag_index_add(TagIndex *index, const GPtrArray *tags, TMTagAttrType *sort_attrs)
+{
+	GHashTable *new_members = g_hash_table_new(g_str_hash, g_str_equal);
+	GHashTableIter iter;
+	gpointer key, value;
+	guint i;
+
+	for (i = 0; i < tags->len; i++)
+	{
+		TMTag *tag = tags->pdata[i];
+		GPtrArray *members;
+
+		if ((tag->type & TM_TYPE_WITH_MEMBERS) && tag->inheritance && tag->inheritance[0])
+			g_hash_table_insert(index->parents, tag, split_inheritance(tag->inheritance));
+
+		if (!tag->scope || !tag->scope[0])
+			continue;
+
+		members = g_hash_table_lookup(new_members, tag->scope);
+		if (!members)
+		{
+			members = g_ptr_array_new();
+			g_hash_table_insert(new_members, tag->scope, members);
+		}
+		g_ptr_array_add(members, tag);
+	}
+
+	g_hash_table_iter_init(&iter, new_members);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		GPtrArray *members = g_hash_table_lookup(index->scopes, key);
+
+		if (members)
+		{
+			GPtrArray *merged = tm_tags_merge(members, value, sort_attrs, FALSE);
+
+			g_ptr_array_free(value, TRUE);
+			value = merged;
+		}
+		g_hash_table_insert(index->scopes, g_strdup(key), value);
+	}
+	g_hash_table_destroy(new_members);
+}
+
+
+/* Removes the tags of source_file from the index, while they still exist */
+static void tag_index_remove_file(TagIndex *index, TMSourceFile *source_file)
+{
+	GHashTable *done = g_hash_table_new(g_str_hash, g_str_equal);
+	guint i;
+
+	for (i = 0; i < source_file->tags_array->len; i++)
+	{
+		TMTag *tag = source_file->tags_array->pdata[i];
+		GPtrArray *members;
+		guint j, count = 0;
+
+		g_hash_table_remove(index->parents, tag);
+
+		if (!tag->scope || !tag->scope[0] || g_hash_table_contains(done, tag->scope))
+			continue;
+		g_hash_table_add(done, tag->scope);
+
+		members = g_hash_table_lookup(index->scopes, tag->scope);
+		if (!members)
+			continue;
+		for (j = 0; j < members->len; j++)
+		{
+			TMTag *member = members->pdata[j];
+
+			if (member->file != source_file)
+				members->pdata[count++] = member;
+		}
+		if (count == 0)
+			g_hash_table_remove(index->scopes, tag->scope);
+		else
+			g_ptr_array_set_size(members, count);
+	}
+	g_hash_table_destroy(done);
+}
+
+
+/* Removes the tags of all the given source files from the index */
+static void tag_index_remove_files(TagIndex *index, GHashTable *source_files)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+
+	g_hash_table_iter_init(&iter, index->scopes);
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+	{
+		GPtrArray *members = value;
+		guint i, count = 0;
+
+		for (i = 0; i < members->len; i++)
+		{
+			TMTag *member = members->pdata[i];
+
+			if (!g_hash_table_contains(source_files, member->file))
+				members->pdata[count++] = member;
+		}
+		if (count == 0)
+			g_hash_table_iter_remove(&iter);
+		else
+			g_ptr_array_set_size(members, count);
+	}
+
+	g_hash_table_iter_init(&iter, index->parents);
+	while (g_hash_table_iter_next(&iter, &key, NULL))
+	{
+		if (g_hash_table_contains(source_files, TM_TAG(key)->file))
+			g_hash_table_iter_remove(&iter);
+	}
+}
+
+
+/* Gets the tags of all with the given scope in the order of all, or NULL if all isn't
+ * indexed */
+static const GPtrArray *tag_index_get_members(const GPtrArray *all, const gchar *scope)
+{
+	static const GPtrArray no_members = {NULL, 0};
+	GHashTable *scopes;
+	const GPtrArray *members;
+
+	if (all == theWorkspace->tags_array)
+		scopes = workspace_index.scopes;
+	else if (all == theWorkspace->global_tags)
+		scopes = global_index.scopes;
+	else
+		return NULL;
+
+	members = g_hash_table_lookup(scopes, scope);
+	return members ? members : &no_members;
+}
+
+
+/* Gets the names of the types type_tag inherits from, NULL if none */
+static gchar **tag_index_get_parents(const TMTag *type_tag)
+{
+	TagIndex *index = type_tag->file ? &workspace_index : &global_index;
+
+	return g_hash_table_lookup(index->parents, type_tag);
+}
+
+
+/* Splits tags into the arrays of their languages */
+static void lang_partitions_fill(GPtrArray **partitions, const GPtrArray *tags)
+{
+	guint i;
+
+	for (i = 0; i < TM_PARSER_COUNT; i++)
+	{
+		if (partitions[i])
+			g_ptr_array_set_size(partitions[i], 0);
+	}
+	for (i = 0; i < tags->len; i++)
+	{
+		TMTag *tag = tags->pdata[i];
+
+		if (tag->lang < 0 || tag->lang >= TM_PARSER_COUNT)
+			continue;
+		if (!partitions[tag->lang])
+			partitions[tag->lang] = g_ptr_array_new();
+		g_ptr_array_add(partitions[tag->lang], tag);
+	}
+}
+
+
+static void lang_partitions_free(GPtrArray **partitions)
+{
+	guint i;
+
+	for (i = 0; i < TM_PARSER_COUNT; i++)
+	{
+		if (partitions[i])
+			g_ptr_array_free(partitions[i], TRUE);
+		partitions[i] = NULL;
+	}
+}
+
+
+/* Stores the non-empty partitions of the languages compatible with lang in
+ * compatible, which must have room for TM_PARSER_COUNT arrays, and returns
+ * their number */
+static guint lang_partitions_get_compatible(GPtrArray **partitions, TMParserType lang,
+	GPtrArray **compatible)
+{
+	TMParserType other;
+	guint count = 0;
+
+	for (other = 0; other < TM_PARSER_COUNT; other++)
+	{
+		if (partitions[other] && partitions[other]->len > 0 &&
+			tm_tag_langs_compatible(lang, other))
+			compatible[count++] = partitions[other];
+	}
+	return count;
+}
+
 
 static gboolean tm_create_workspace(void)
 {
@@ -77,6 +367,8 @@ static gboolean tm_create_workspace(void)
 	theWorkspace->source_files = g_ptr_array_new();
 	theWorkspace->typename_array = g_ptr_array_new();
 	theWorkspace->global_typename_array = g_ptr_array_new();
+	tag_index_init(&workspace_index);
+	tag_index_init(&global_index);
 
 	tm_ctags_init();
 	tm_parser_verify_type_mappings();
@@ -103,6 +395,10 @@ void tm_workspace_free(void)
 	g_ptr_array_free(theWorkspace->tags_array, TRUE);
 	g_ptr_array_free(theWorkspace->typename_array, TRUE);
 	g_ptr_array_free(theWorkspace->global_typename_array, TRUE);
+	tag_index_free(&workspace_index);
+	tag_index_free(&global_index);
+	lang_partitions_free(global_lang_tags);
+	lang_partitions_free(global_lang_typenames);
 	g_free(theWorkspace);
 	theWorkspace = NULL;
 }
@@ -122,12 +418,17 @@ const TMWorkspace *tm_get_workspace(void)
 }
 
 
-static void tm_workspace_merge_tags(GPtrArray **big_array, GPtrArray *small_array)
+/* index is the index of big_array to update, if any */
+static void tm_workspace_merge_tags(GPtrArray **big_array, GPtrArray *small_array,
+	TagIndex *index)
 {
 	GPtrArray *new_tags = tm_tags_merge(*big_array, small_array, workspace_tags_sort_attrs, FALSE);
 	/* tags owned by TMSourceFile - free just the pointer array */
 	g_ptr_array_free(*big_array, TRUE);
 	*big_array = new_tags;
+
+	if (index)
+		tag_index_add(index, small_array, workspace_tags_sort_attrs);
 }
 
 
@@ -136,7 +437,7 @@ static void merge_extracted_tags(GPtrArray **dest, GPtrArray *src, TMTagType tag
 	GPtrArray *arr;
 
 	arr = tm_tags_extract(src, tag_types);
-	tm_workspace_merge_tags(dest, arr);
+	tm_workspace_merge_tags(dest, arr, NULL);
 	g_ptr_array_free(arr, TRUE);
 }
 
@@ -154,15 +455,18 @@ static void update_source_file(TMSourceFile *source_file, guchar* text_buf,
 		 * workspace while they exist and can be scanned */
 		tm_tags_remove_file_tags(source_file, theWorkspace->tags_array);
 		tm_tags_remove_file_tags(source_file, theWorkspace->typename_array);
+		tag_index_remove_file(&workspace_index, source_file);
 	}
 	tm_source_file_parse(source_file, text_buf, buf_size, use_buffer);
-	tm_tags_sort(source_file->tags_array, file_tags_sort_attrs, FALSE, TRUE);
+	/* deduplicated so the file's tags can be k-way merged by merge_source_files_tags() */
+	tm_tags_sort(source_file->tags_array, file_tags_sort_attrs, TRUE, TRUE);
 	if (update_workspace)
 	{
 #ifdef TM_DEBUG
 		g_message("Updating workspace from source file");
 #endif
-		tm_workspace_merge_tags(&theWorkspace->tags_array, source_file->tags_array);
+		tm_workspace_merge_tags(&theWorkspace->tags_array, source_file->tags_array,
+			&workspace_index);
 
 		merge_extracted_tags(&(theWorkspace->typename_array), source_file->tags_array, TM_GLOBAL_TYPE_MASK);
 	}
@@ -233,6 +537,7 @@ void tm_workspace_remove_source_file(TMSourceFile *source_file)
 		{
 			tm_tags_remove_file_tags(source_file, theWorkspace->tags_array);
 			tm_tags_remove_file_tags(source_file, theWorkspace->typename_array);
+			tag_index_remove_file(&workspace_index, source_file);
 			g_ptr_array_remove_index_fast(theWorkspace->source_files, i);
 			return;
 		}
@@ -240,47 +545,60 @@ void tm_workspace_remove_source_file(TMSourceFile *source_file)
 }
 
 
-/* Recreates workspace tag array from all member TMSourceFile objects. Use if you 
- want to globally refresh the workspace. This function does not call tm_source_file_update()
- which should be called before this function on source files which need to be
- reparsed.
+/* Removes the tags of all the given source files from a workspace tag array in a
+ single pass, keeping it sorted. */
+static void remove_source_files_tags(GPtrArray *tags_array, GHashTable *source_files)
+{
+	guint i, count = 0;
+
+	for (i = 0; i < tags_array->len; i++)
+	{
+		TMTag *tag = tags_array->pdata[i];
+
+		if (!g_hash_table_contains(source_files, tag->file))
+			tags_array->pdata[count++] = tag;
+	}
+	g_ptr_array_set_size(tags_array, count);
+}
+
+
+/* Merges the tags of newly parsed source files into the workspace tag arrays. The
+ workspace array and the tag arrays of the source files are already sorted (the
+ latter on file_tags_sort_attrs which gives the same order for tags of a single file),
+ update_source_file() removes duplicates within a file and tags of different files
+ never compare equal so a k-way merge of them gives the same result as sorting all
+ the tags again.
 */
-static void tm_workspace_update(void)
+static void merge_source_files_tags(GPtrArray *source_files)
 {
-	guint i, j;
-	TMSourceFile *source_file;
+	GPtrArray *arrays = g_ptr_array_sized_new(source_files->len + 1);
+	GPtrArray *new_tags;
+	guint i;
 
 #ifdef TM_DEBUG
-	g_message("Recreating workspace tags array");
+	g_message("Merging tags of %u source files to workspace", source_files->len);
 #endif
 
-	g_ptr_array_set_size(theWorkspace->tags_array, 0);
+	g_ptr_array_add(arrays, theWorkspace->tags_array);
+	for (i = 0; i < source_files->len; i++)
+		g_ptr_array_add(arrays, TM_SOURCE_FILE(source_files->pdata[i])->tags_array);
+
+	new_tags = tm_tags_merge_sorted(arrays, workspace_tags_sort_attrs);
+	g_ptr_array_free(arrays, TRUE);
+	g_ptr_array_free(theWorkspace->tags_array, TRUE);
+	theWorkspace->tags_array = new_tags;
 
-#ifdef TM_DEBUG
-	g_message("Total %d objects", theWorkspace->source_files->len);
-#endif
-	for (i=0; i < theWorkspace->source_files->len; ++i)
-	{
-		source_file = theWorkspace->source_files->pdata[i];
-#ifdef TM_DEBUG
-		g_message("Adding tags of %s", source_file->file_name);
-#endif
-		if (source_file->tags_array->len > 0)
-		{
-			for (j = 0; j < source_file->tags_array->len; ++j)
-			{
-				g_ptr_array_add(theWorkspace->tags_array,
-					source_file->tags_array->pdata[j]);
-			}
-		}
-	}
 #ifdef TM_DEBUG
 	g_message("Total: %d tags", theWorkspace->tags_array->len);
 #endif
-	tm_tags_sort(theWorkspace->tags_array, workspace_tags_sort_attrs, TRUE, FALSE);
 
+	/* extracting keeps the order */
 	g_ptr_array_free(theWorkspace->typename_array, TRUE);
 	theWorkspace->typename_array = tm_tags_extract(theWorkspace->tags_array, TM_GLOBAL_TYPE_MASK);
+
+	/* the new tags may be spread over most of the scopes, index them all again */
+	tag_index_clear(&workspace_index);
+	tag_index_add(&workspace_index, theWorkspace->tags_array, workspace_tags_sort_attrs);
 }
 
 
@@ -292,19 +610,50 @@ static void tm_workspace_update(void)
 GEANY_API_SYMBOL
 void tm_workspace_add_source_files(GPtrArray *source_files)
 {
+	GHashTable *added, *present;
+	GPtrArray *parsed;
 	guint i;
 
 	g_return_if_fail(source_files != NULL);
 
+	added = g_hash_table_new(g_direct_hash, g_direct_equal);
+	for (i = 0; i < source_files->len; i++)
+		g_hash_table_add(added, source_files->pdata[i]);
+
+	/* files already in the workspace get reparsed so drop their tags first */
+	present = g_hash_table_new(g_direct_hash, g_direct_equal);
+	for (i = 0; i < theWorkspace->source_files->len; i++)
+	{
+		TMSourceFile *source_file = theWorkspace->source_files->pdata[i];
+
+		if (g_hash_table_contains(added, source_file))
+			g_hash_table_add(present, source_file);
+	}
+	if (g_hash_table_size(present) > 0)
+	{
+		remove_source_files_tags(theWorkspace->tags_array, present);
+		remove_source_files_tags(theWorkspace->typename_array, present);
+		tag_index_remove_files(&workspace_index, present);
+	}
+
+	parsed = g_ptr_array_sized_new(source_files->len);
 	for (i = 0; i < source_files->len; i++)
 	{
 		TMSourceFile *source_file = source_files->pdata[i];
-		
-		tm_workspace_add_source_file_noupdate(source_file);
+
+		/* skip files listed more than once */
+		if (!g_hash_table_remove(added, source_file))
+			continue;
+		if (!g_hash_table_contains(present, source_file))
+			tm_workspace_add_source_file_noupdate(source_file);
 		update_source_file(source_file, NULL, 0, FALSE, FALSE);
+		g_ptr_array_add(parsed, source_file);
 	}
-	
-	tm_workspace_update();
+	g_hash_table_destroy(added);
+	g_hash_table_destroy(present);
+
+	merge_source_files_tags(parsed);
+	g_ptr_array_free(parsed, TRUE);
 }
 
 
@@ -317,44 +666,55 @@ void tm_workspace_add_source_files(GPtrArray *source_files)
 GEANY_API_SYMBOL
 void tm_workspace_remove_source_files(GPtrArray *source_files)
 {
-	guint i, j;
+	GHashTable *removed;
+	guint i, count = 0;
 
 	g_return_if_fail(source_files != NULL);
 
-	//TODO: sort both arrays by pointer value and remove in single pass
+	removed = g_hash_table_new(g_direct_hash, g_direct_equal);
 	for (i = 0; i < source_files->len; i++)
+		g_hash_table_add(removed, source_files->pdata[i]);
+
+	for (i = 0; i < theWorkspace->source_files->len; i++)
 	{
-		TMSourceFile *source_file = source_files->pdata[i];
-		
-		for (j = 0; j < theWorkspace->source_files->len; j++)
-		{
-			if (theWorkspace->source_files->pdata[j] == source_file)
-			{
-				g_ptr_array_remove_index_fast(theWorkspace->source_files, j);
-				break;
-			}
-		}
+		TMSourceFile *source_file = theWorkspace->source_files->pdata[i];
+
+		if (!g_hash_table_contains(removed, source_file))
+			theWorkspace->source_files->pdata[count++] = source_file;
 	}
-	
-	tm_workspace_update();
+	g_ptr_array_set_size(theWorkspace->source_files, count);
+
+	remove_source_files_tags(theWorkspace->tags_array, removed);
+	remove_source_files_tags(theWorkspace->typename_array, removed);
+	tag_index_remove_files(&workspace_index, removed);
+	g_hash_table_destroy(removed);
 }
 
 
-/* Loads the global tag list from the specified file. The global tag list should
- have been first created using tm_workspace_create_global_tags().
+/* Reads the tags of a global tags file and sorts them for
+ tm_workspace_add_global_tags(). Doesn't access the workspace so it can be
+ called from any thread, e.g. to read big tags files in the background.
  @param tags_file The file containing global tags.
- @return TRUE on success, FALSE on failure.
- @see tm_workspace_create_global_tags()
+ @param mode The language of the tags file.
+ @return The tags, or NULL on failure.
+ @see tm_workspace_add_global_tags()
 */
-gboolean tm_workspace_load_global_tags(const char *tags_file, TMParserType mode)
+GPtrArray *tm_workspace_read_global_tags(const char *tags_file, TMParserType mode)
 {
-	GPtrArray *file_tags, *new_tags;
+	GPtrArray *file_tags = tm_source_file_read_tags_file(tags_file, mode);
 
-	file_tags = tm_source_file_read_tags_file(tags_file, mode);
-	if (!file_tags)
-		return FALSE;
+	if (file_tags)
+		tm_tags_sort(file_tags, global_tags_sort_attrs, TRUE, TRUE);
+	return file_tags;
+}
 
-	tm_tags_sort(file_tags, global_tags_sort_attrs, TRUE, TRUE);
+
+/* Adds tags read with tm_workspace_read_global_tags() to the global tags.
+ @param file_tags The tags to add, freed by this function.
+*/
+void tm_workspace_add_global_tags(GPtrArray *file_tags)
+{
+	GPtrArray *new_tags;
 
 	/* reorder the whole array, because tm_tags_find expects a sorted array */
 	new_tags = tm_tags_merge(theWorkspace->global_tags, 
@@ -366,6 +726,28 @@ gboolean tm_workspace_load_global_tags(const char *tags_file, TMParserType mode)
 	g_ptr_array_free(theWorkspace->global_typename_array, TRUE);
 	theWorkspace->global_typename_array = tm_tags_extract(new_tags, TM_GLOBAL_TYPE_MASK);
 
+	/* duplicates of the loaded tags have been dropped, index them all again */
+	tag_index_clear(&global_index);
+	tag_index_add(&global_index, new_tags, global_tags_sort_attrs);
+	lang_partitions_fill(global_lang_tags, new_tags);
+	lang_partitions_fill(global_lang_typenames, theWorkspace->global_typename_array);
+}
+
+
+/* Loads the global tag list from the specified file. The global tag list should
+ have been first created using tm_workspace_create_global_tags().
+ @param tags_file The file containing global tags.
+ @return TRUE on success, FALSE on failure.
+ @see tm_workspace_create_global_tags()
+*/
+gboolean tm_workspace_load_global_tags(const char *tags_file, TMParserType mode)
+{
+	GPtrArray *file_tags = tm_workspace_read_global_tags(tags_file, mode);
+
+	if (!file_tags)
+		return FALSE;
+
+	tm_workspace_add_global_tags(file_tags);
 	return TRUE;
 }
 
@@ -387,17 +769,6 @@ static guint tm_file_inode_hash(gconstpointer key)
 }
 
 
-static void tm_move_entries_to_g_list(gpointer key, gpointer value, gpointer user_data)
-{
-	GList **pp_list = (GList**)user_data;
-
-	if (user_data == NULL)
-		return;
-
-	*pp_list = g_list_prepend(*pp_list, g_strdup(value));
-}
-
-
 static gboolean write_includes_file(const gchar *outf, GList *includes_files)
 {
 	FILE *fp = g_fopen(outf, "w");
@@ -516,6 +887,7 @@ static GList *lookup_includes(const gchar **includes, gint includes_count)
 					gchar *file_name_copy = g_strdup(globbuf.gl_pathv[idx_glob]);
 
 					g_hash_table_insert(table, file_name_copy, file_name_copy);
+					includes_files = g_list_prepend(includes_files, g_strdup(file_name_copy));
 #ifdef TM_DEBUG
 					g_message ("Added ...\n");
 #endif
@@ -536,23 +908,47 @@ static GList *lookup_includes(const gchar **includes, gint includes_count)
 				gchar* file_name_copy = g_strdup(includes[i]);
 
 				g_hash_table_insert(table, file_name_copy, file_name_copy);
+				includes_files = g_list_prepend(includes_files, g_strdup(file_name_copy));
 			}
 		}
 	}
 
-	g_hash_table_foreach(table, tm_move_entries_to_g_list, &includes_files);
 	g_hash_table_destroy(table);
 
-	return includes_files;
+	/* keep the order of the includes, headers may depend on those before them */
+	return g_list_reverse(includes_files);
+}
+
+static guint get_processor_count(void)
+{
+#if GLIB_CHECK_VERSION(2, 36, 0)
+	return g_get_num_processors();
+#else
+	return 4;
+#endif
+}
+
+/* Whether the status returned by system() is that of a command exiting with 0 */
+static gboolean command_succeeded(gint status)
+{
+#ifdef G_OS_WIN32
+	return status == 0;
+#else
+	return status != -1 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#endif
 }
 
-static gchar *pre_process_file(const gchar *cmd, const gchar *inf)
+/* Returns the file with the output of the pre-processing command, NULL if the
+ * command failed. The error output of a failed command is only printed when
+ * show_failure is set. */
+static gchar *pre_process_file(const gchar *cmd, const gchar *inf, gboolean show_failure)
 {
 	gint ret;
 	gchar *outf = create_temp_file("tmp_XXXXXX.cpp");
 	gchar *tmp_errfile;
 	gchar *errors = NULL;
 	gchar *command;
+	gboolean failed;
 
 	if (!outf)
 		return NULL;
@@ -572,15 +968,16 @@ static gchar *pre_process_file(const gchar *cmd, const gchar *inf)
 #endif
 	ret = system(command);
 	g_free(command);
+	failed = !command_succeeded(ret);
 
 	g_file_get_contents(tmp_errfile, &errors, NULL, NULL);
-	if (errors && *errors)
+	if (errors && *errors && (show_failure || !failed))
 		g_printerr("%s", errors);
 	g_free(errors);
 	g_unlink(tmp_errfile);
 	g_free(tmp_errfile);
 
-	if (ret == -1)
+	if (failed)
 	{
 		g_unlink(outf);
 		g_free(outf);
@@ -590,74 +987,312 @@ static gchar *pre_process_file(const gchar *cmd, const gchar *inf)
 	return outf;
 }
 
+/* Include files of a global tags file preprocessed and parsed together, and
+ * cached together in the cache directory */
+typedef struct
+{
+	GList *files;
+	gchar *temp_file;	/* file with the batch to parse, NULL if failed */
+} GlobalTagsBatch;
+
+
+/* Whether the line is a line marker of the preprocessor like # 1 "file.h" or #line 1 */
+static gboolean is_line_marker(const gchar *line, const gchar *end)
+{
+	if (line >= end || *line != '#')
+		return FALSE;
+	for (line++; line < end && (*line == ' ' || *line == '\t'); line++);
+	return line < end && (g_ascii_isdigit(*line) ||
+		(end - line >= 4 && strncmp(line, "line", 4) == 0));
+}
+
+
+/* Gets the cache file of the tags of the batch's file to parse, named after
+ * everything the tags depend on: the language, the C ignore list and the
+ * contents of the file, which with preprocessing include all headers the batch
+ * includes. Line markers are left out, they contain the name of the temporary
+ * file and the tags don't store lines. */
+static gchar *get_batch_cache_file(const gchar *cache_dir, const gchar *temp_file,
+	TMParserType lang)
+{
+	GChecksum *checksum;
+	const gchar *const *ignore;
+	gchar *contents, *line, *end, *name, *cache_file;
+	gsize length;
+
+	if (!g_file_get_contents(temp_file, &contents, &length, NULL))
+		return NULL;
+
+	checksum = g_checksum_new(G_CHECKSUM_SHA1);
+	g_checksum_update(checksum, (const guchar *) tm_source_file_get_lang_name(lang), -1);
+	for (ignore = tm_ctags_get_ignore_tags(); ignore && *ignore; ignore++)
+	{
+		g_checksum_update(checksum, (const guchar *) " ", 1);
+		g_checksum_update(checksum, (const guchar *) *ignore, -1);
+	}
+	g_checksum_update(checksum, (const guchar *) "\n", 1);
+
+	end = contents + length;
+	for (line = contents; line < end; )
+	{
+		gchar *eol = memchr(line, '\n', end - line);
+		gchar *next = eol ? eol + 1 : end;
+
+		if (!is_line_marker(line, next))
+			g_checksum_update(checksum, (const guchar *) line, next - line);
+		line = next;
+	}
+	g_free(contents);
+
+	name = g_strconcat(g_checksum_get_string(checksum), ".tags", NULL);
+	cache_file = g_build_filename(cache_dir, name, NULL);
+	g_free(name);
+	g_checksum_free(checksum);
+	return cache_file;
+}
+
+
+/* Removes the tags of batches which weren't used for GLOBAL_TAGS_CACHE_MAX_AGE
+ * from the cache */
+static void prune_global_tags_cache(const gchar *cache_dir)
+{
+	GDir *dir = g_dir_open(cache_dir, 0, NULL);
+	gint64 now = g_get_real_time() / G_USEC_PER_SEC;
+	const gchar *name;
+
+	if (!dir)
+		return;
+
+	while ((name = g_dir_read_name(dir)) != NULL)
+	{
+		gchar *path;
+		GStatBuf st;
+
+		if (!g_str_has_suffix(name, ".tags"))
+			continue;
+		path = g_build_filename(cache_dir, name, NULL);
+		if (g_stat(path, &st) == 0 && now - (gint64) st.st_mtime > GLOBAL_TAGS_CACHE_MAX_AGE)
+			g_unlink(path);
+		g_free(path);
+	}
+	g_dir_close(dir);
+}
+
+
+/* Replaces the batch's file of includes by the preprocessed output */
+static void pre_process_batch_file(GlobalTagsBatch *batch, const gchar *pre_process,
+	gboolean show_failure)
+{
+	gchar *temp_file = pre_process_file(pre_process, batch->temp_file, show_failure);
+
+	g_unlink(batch->temp_file);
+	g_free(batch->temp_file);
+	batch->temp_file = temp_file;
+}
+
+
+/* Runs in a thread of the pool; the errors of failing batches aren't shown as
+ * they are processed again as a single unit */
+static void pre_process_batch(gpointer data, gpointer user_data)
+{
+	pre_process_batch_file(data, user_data, FALSE);
+}
+
+
+/* Returns the tags of the batch sorted and without duplicates, read from the
+ * cache or parsed and then stored in the cache if cache_dir is set */
+static GPtrArray *get_batch_tags(GlobalTagsBatch *batch, TMParserType lang,
+	const gchar *cache_dir)
+{
+	GPtrArray *tags = NULL;
+	TMSourceFile *source_file;
+	gchar *cache_file = NULL;
+	guint i;
+
+	if (!batch->temp_file)
+		return NULL;
+
+	if (cache_dir)
+		cache_file = get_batch_cache_file(cache_dir, batch->temp_file, lang);
+	if (cache_file && g_file_test(cache_file, G_FILE_TEST_EXISTS))
+	{
+		tags = tm_source_file_read_tags_file(cache_file, lang);
+		if (tags)
+		{
+			/* keep the entry from being pruned */
+			g_utime(cache_file, NULL);
+			g_free(cache_file);
+			tm_tags_sort(tags, global_tags_sort_attrs, TRUE, TRUE);
+			return tags;
+		}
+	}
+
+	source_file = tm_source_file_new(batch->temp_file, tm_source_file_get_lang_name(lang));
+	if (!source_file)
+	{
+		g_free(cache_file);
+		return NULL;
+	}
+	update_source_file(source_file, NULL, 0, FALSE, FALSE);
+
+	/* keep the tags when the source file is freed */
+	tags = g_ptr_array_sized_new(source_file->tags_array->len);
+	for (i = 0; i < source_file->tags_array->len; i++)
+		g_ptr_array_add(tags, tm_tag_ref(source_file->tags_array->pdata[i]));
+	tm_source_file_free(source_file);
+
+	tm_tags_sort(tags, global_tags_sort_attrs, TRUE, TRUE);
+	if (cache_file && !tm_source_file_write_tags_file(cache_file, tags))
+		g_unlink(cache_file);
+	g_free(cache_file);
+	return tags;
+}
+
+
+/* Returns the tags of the include files processed in batches of batch_size
+ files, NULL if any of the batches failed */
+static GPtrArray *create_batched_tags(const gchar *pre_process, GList *includes_files,
+	guint batch_size, TMParserType lang, const gchar *cache_dir)
+{
+	gboolean ret = TRUE;
+	GList *node;
+	GPtrArray *batches = g_ptr_array_new();
+	GPtrArray *tags = g_ptr_array_new();
+	GThreadPool *pool = NULL;
+	guint i;
+
+	for (node = includes_files; node; )
+	{
+		GlobalTagsBatch *batch = g_new0(GlobalTagsBatch, 1);
+
+		for (i = 0; node && i < batch_size; i++, node = node->next)
+			batch->files = g_list_prepend(batch->files, node->data);
+		batch->files = g_list_reverse(batch->files);
+		g_ptr_array_add(batches, batch);
+	}
+
+	for (i = 0; ret && i < batches->len; i++)
+	{
+		GlobalTagsBatch *batch = batches->pdata[i];
+
+		batch->temp_file = create_temp_file("tmp_XXXXXX.cpp");
+		if (!batch->temp_file)
+		{
+			ret = FALSE;
+			break;
+		}
+#ifdef TM_DEBUG
+		g_message ("writing out files to %s\n", batch->temp_file);
+#endif
+		if (pre_process)
+			ret = write_includes_file(batch->temp_file, batch->files);
+		else
+			ret = combine_include_files(batch->temp_file, batch->files);
+		if (!ret)
+			break;
+
+		/* only the preprocessor runs in parallel, the parser can't */
+		if (pre_process && batches->len > 1)
+		{
+			if (!pool)
+				pool = g_thread_pool_new(pre_process_batch, (gpointer) pre_process,
+					get_processor_count(), TRUE, NULL);
+			g_thread_pool_push(pool, batch, NULL);
+		}
+		else if (pre_process)
+			pre_process_batch_file(batch, pre_process, TRUE);
+	}
+	if (pool)
+		g_thread_pool_free(pool, FALSE, TRUE);	/* waits for the batches */
+
+	for (i = 0; ret && i < batches->len; i++)
+	{
+		GlobalTagsBatch *batch = batches->pdata[i];
+		GPtrArray *batch_tags = get_batch_tags(batch, lang, cache_dir);
+
+		if (batch_tags)
+		{
+			/* the files of several batches may include the same headers */
+			GPtrArray *new_tags = tm_tags_merge(tags, batch_tags, global_tags_sort_attrs, TRUE);
+
+			g_ptr_array_free(tags, TRUE);
+			g_ptr_array_free(batch_tags, TRUE);
+			tags = new_tags;
+		}
+		else
+			ret = FALSE;
+	}
+
+	for (i = 0; i < batches->len; i++)
+	{
+		GlobalTagsBatch *batch = batches->pdata[i];
+
+		if (batch->temp_file)
+			g_unlink(batch->temp_file);
+		g_free(batch->temp_file);
+		g_list_free(batch->files);
+		g_free(batch);
+	}
+	g_ptr_array_free(batches, TRUE);
+
+	if (!ret)
+	{
+		tm_tags_array_free(tags, TRUE);
+		return NULL;
+	}
+	return tags;
+}
+
+
 /* Creates a list of global tags. Ideally, this should be created once during
  installations so that all users can use the same file. This is because a full
  scale global tag list can occupy several megabytes of disk space.
+
+ The include files are split into batches of consecutive files which are
+ preprocessed in parallel and parsed one after the other, their tags are then
+ merged. If preprocessing any of the batches fails, e.g. because of headers which
+ depend on the headers before them or can only be included by other headers, all
+ the files are preprocessed and parsed together instead. When a cache directory
+ is given, the tags of every batch are stored there and reused by later calls
+ as long as the preprocessed batch is the same, only its parsing is skipped.
+ Entries of the cache unused for 30 days are removed.
  @param pre_process The pre-processing command. This is executed via system(),
  so you can pass stuff like 'gcc -E -dD -P `gnome-config --cflags gnome`'.
  @param includes Include files to process. Wildcards such as '/usr/include/a*.h'
  are allowed.
+ @param includes_count The number of include files.
  @param tags_file The file where the tags will be stored.
  @param lang The language to use for the tags file.
+ @param cache_dir The existing directory to cache the tags of the batches in,
+ or NULL to always parse all files.
  @return TRUE on success, FALSE on failure.
 */
 gboolean tm_workspace_create_global_tags(const char *pre_process, const char **includes,
-	int includes_count, const char *tags_file, TMParserType lang)
+	int includes_count, const char *tags_file, TMParserType lang, const char *cache_dir)
 {
 	gboolean ret = FALSE;
-	TMSourceFile *source_file;
-	GList *includes_files;
-	gchar *temp_file = create_temp_file("tmp_XXXXXX.cpp");
-
-	if (!temp_file)
-		return FALSE;
-
-	includes_files = lookup_includes(includes, includes_count);
+	GList *includes_files = lookup_includes(includes, includes_count);
+	GPtrArray *tags;
 
+	tags = create_batched_tags(pre_process, includes_files, GLOBAL_TAGS_BATCH_SIZE,
+		lang, cache_dir);
+	if (!tags && pre_process && g_list_length(includes_files) > GLOBAL_TAGS_BATCH_SIZE)
+	{
 #ifdef TM_DEBUG
-	g_message ("writing out files to %s\n", temp_file);
+		g_message("preprocessing in batches failed, processing all files together");
 #endif
-	if (pre_process)
-		ret = write_includes_file(temp_file, includes_files);
-	else
-		ret = combine_include_files(temp_file, includes_files);
-
-	g_list_free_full(includes_files, g_free);
-	if (!ret)
-		goto cleanup;
-	ret = FALSE;
-
-	if (pre_process)
-	{
-		gchar *temp_file2 = pre_process_file(pre_process, temp_file);
-
-		if (temp_file2)
-		{
-			g_unlink(temp_file);
-			g_free(temp_file);
-			temp_file = temp_file2;
-		}
-		else
-			goto cleanup;
+		tags = create_batched_tags(pre_process, includes_files, G_MAXUINT, lang, cache_dir);
 	}
+	if (cache_dir)
+		prune_global_tags_cache(cache_dir);
 
-	source_file = tm_source_file_new(temp_file, tm_source_file_get_lang_name(lang));
-	if (!source_file)
-		goto cleanup;
-	update_source_file(source_file, NULL, 0, FALSE, FALSE);
-	if (source_file->tags_array->len == 0)
+	if (tags)
 	{
-		tm_source_file_free(source_file);
-		goto cleanup;
+		if (tags->len > 0)
+			ret = tm_source_file_write_tags_file(tags_file, tags);
+		tm_tags_array_free(tags, TRUE);
 	}
-
-	tm_tags_sort(source_file->tags_array, global_tags_sort_attrs, TRUE, FALSE);
-	ret = tm_source_file_write_tags_file(tags_file, source_file->tags_array);
-	tm_source_file_free(source_file);
-
-cleanup:
-	g_unlink(temp_file);
-	g_free(temp_file);
+	g_list_free_full(includes_files, g_free);
 	return ret;
 }
 
@@ -685,6 +1320,33 @@ static void fill_find_tags_array(GPtrArray *dst, const GPtrArray *src,
 }
 
 
+/* Like fill_find_tags_array() for the global tags, but only searches the
+ languages compatible with lang */
+static void fill_find_global_tags_array(GPtrArray *dst, const char *name, const char *scope,
+	TMTagType type, TMParserType lang)
+{
+	GPtrArray *partitions[TM_PARSER_COUNT];
+	guint count = lang_partitions_get_compatible(global_lang_tags, lang, partitions);
+	GPtrArray *found;
+	guint i;
+
+	if (count == 1)
+	{
+		fill_find_tags_array(dst, partitions[0], name, scope, type, lang);
+		return;
+	}
+
+	found = g_ptr_array_new();
+	for (i = 0; i < count; i++)
+		fill_find_tags_array(found, partitions[i], name, scope, type, lang);
+	/* return them in the order of the global tags */
+	tm_tags_sort(found, global_tags_sort_attrs, FALSE, FALSE);
+	for (i = 0; i < found->len; i++)
+		g_ptr_array_add(dst, found->pdata[i]);
+	g_ptr_array_free(found, TRUE);
+}
+
+
 /* Returns all matching tags found in the workspace.
  @param name The name of the tag to find.
  @param scope The scope name of the tag to find, or NULL.
@@ -700,7 +1362,7 @@ GPtrArray *tm_workspace_find(const char *name, const char *scope, TMTagType type
 	GPtrArray *tags = g_ptr_array_new();
 
 	fill_find_tags_array(tags, theWorkspace->tags_array, name, scope, type, lang);
-	fill_find_tags_array(tags, theWorkspace->global_tags, name, scope, type, lang);
+	fill_find_global_tags_array(tags, name, scope, type, lang);
 
 	if (attrs)
 		tm_tags_sort(tags, attrs, TRUE, FALSE);
@@ -709,6 +1371,52 @@ GPtrArray *tm_workspace_find(const char *name, const char *scope, TMTagType type
 }
 
 
+/* Returns the global type name tags compatible with lang, in the same order
+ as in theWorkspace->global_typename_array.
+ @param lang The language of the type names.
+ @return Array of TMTag, free with g_ptr_array_free(). */
+GPtrArray *tm_workspace_find_global_typenames(TMParserType lang)
+{
+	GPtrArray *partitions[TM_PARSER_COUNT];
+	GPtrArray *arrays = g_ptr_array_new();
+	GPtrArray *typenames;
+	guint i, count;
+
+	count = lang_partitions_get_compatible(global_lang_typenames, lang, partitions);
+	for (i = 0; i < count; i++)
+		g_ptr_array_add(arrays, partitions[i]);
+	typenames = tm_tags_merge_sorted(arrays, global_tags_sort_attrs);
+
+	g_ptr_array_free(arrays, TRUE);
+	return typenames;
+}
+
+
+/* Returns the source files of the workspace in which the token appears, using the
+ occurrence index built when parsing them. Files which aren't indexed are always
+ returned as they may contain the token.
+ @param token The identifier to find, see tm_source_file_get_occurrences().
+ @return Array of TMSourceFile, the lines are available from
+ tm_source_file_get_occurrences(). Free with g_ptr_array_free(). */
+GPtrArray *tm_workspace_find_occurrences(const gchar *token)
+{
+	GPtrArray *source_files = g_ptr_array_new();
+	guint i;
+
+	g_return_val_if_fail(token != NULL, source_files);
+
+	for (i = 0; i < theWorkspace->source_files->len; i++)
+	{
+		TMSourceFile *source_file = theWorkspace->source_files->pdata[i];
+
+		if (!tm_source_file_has_occurrence_index(source_file) ||
+			tm_source_file_get_occurrences(source_file, token))
+			g_ptr_array_add(source_files, source_file);
+	}
+	return source_files;
+}
+
+
 static void fill_find_tags_array_prefix(GPtrArray *dst, const GPtrArray *src,
 	const char *name, TMParserType lang, guint max_num)
 {
@@ -747,9 +1455,15 @@ GPtrArray *tm_workspace_find_prefix(const char *prefix, TMParserType lang, guint
 {
 	TMTagAttrType attrs[] = { tm_tag_attr_name_t, 0 };
 	GPtrArray *tags = g_ptr_array_new();
+	GPtrArray *partitions[TM_PARSER_COUNT];
+	guint i, count;
 
 	fill_find_tags_array_prefix(tags, theWorkspace->tags_array, prefix, lang, max_num);
-	fill_find_tags_array_prefix(tags, theWorkspace->global_tags, prefix, lang, max_num);
+	/* the first max_num names of every language are enough for the first
+	 * max_num names of all of them */
+	count = lang_partitions_get_compatible(global_lang_tags, lang, partitions);
+	for (i = 0; i < count; i++)
+		fill_find_tags_array_prefix(tags, partitions[i], prefix, lang, max_num);
 
 	tm_tags_sort(tags, attrs, TRUE, FALSE);
 	if (tags->len > max_num)
@@ -759,32 +1473,27 @@ GPtrArray *tm_workspace_find_prefix(const char *prefix, TMParserType lang, guint
 }
 
 
-/* Gets all members of type_tag; search them inside the all array.
- * The namespace parameter determines whether we are performing the "namespace"
- * search (user has typed something like "A::" where A is a type) or "scope" search
- * (user has typed "a." where a is a global struct-like variable). With the
- * namespace search we return all direct descendants of any type while with the
- * scope search we return only those which can be invoked on a variable (member,
- * method, etc.). */
-static GPtrArray *
-find_scope_members_tags (const GPtrArray *all, TMTag *type_tag, gboolean namespace)
+/* Appends the member_types tags of type_tag found in all to tags */
+static void add_scope_members_tags(GPtrArray *tags, const GPtrArray *all, TMTag *type_tag,
+	TMTagType member_types, gboolean namespace)
 {
-	TMTagType member_types = tm_tag_max_t & ~(TM_TYPE_WITH_MEMBERS | tm_tag_typedef_t);
-	GPtrArray *tags = g_ptr_array_new();
+	const GPtrArray *candidates;
 	gchar *scope;
 	guint i;
 
-	if (namespace)
-		member_types = tm_tag_max_t;
-
 	if (type_tag->scope && *(type_tag->scope))
 		scope = g_strconcat(type_tag->scope, tm_tag_context_separator(type_tag->lang), type_tag->name, NULL);
 	else
 		scope = g_strdup(type_tag->name);
 
-	for (i = 0; i < all->len; ++i)
+	/* only the tags with this scope if all is indexed */
+	candidates = tag_index_get_members(all, scope);
+	if (!candidates)
+		candidates = all;
+
+	for (i = 0; i < candidates->len; ++i)
 	{
-		TMTag *tag = TM_TAG (all->pdata[i]);
+		TMTag *tag = TM_TAG (candidates->pdata[i]);
 
 		if (tag && (tag->type & member_types) &&
 			tag->scope && tag->scope[0] != '\0' &&
@@ -797,6 +1506,103 @@ find_scope_members_tags (const GPtrArray *all, TMTag *type_tag, gboolean namespa
 	}
 
 	g_free(scope);
+}
+
+
+/* Finds the type named in the inheritance of type_tag, possibly with its scope */
+static TMTag *find_parent_type(const gchar *name, const TMTag *type_tag)
+{
+	const gchar *sep = tm_tag_context_separator(type_tag->lang);
+	const gchar *base = g_strrstr(name, sep);
+	GPtrArray *types = g_ptr_array_new();
+	gchar *scope = NULL;
+	TMTag *parent = NULL;
+
+	if (base)
+	{
+		if (base > name)
+			scope = g_strndup(name, base - name);
+		name = base + strlen(sep);
+	}
+
+	/* prefer the workspace like the rest of the member search */
+	fill_find_tags_array(types, theWorkspace->tags_array, name, scope, TM_TYPE_WITH_MEMBERS, type_tag->lang);
+	if (types->len == 0)
+		fill_find_global_tags_array(types, name, scope, TM_TYPE_WITH_MEMBERS, type_tag->lang);
+	if (types->len > 0)
+		parent = types->pdata[0];
+
+	g_ptr_array_free(types, TRUE);
+	g_free(scope);
+	return parent;
+}
+
+
+/* Gets all members of type_tag; search them inside the all array.
+ * The namespace parameter determines whether we are performing the "namespace"
+ * search (user has typed something like "A::" where A is a type) or "scope" search
+ * (user has typed "a." where a is a global struct-like variable). With the
+ * namespace search we return all direct descendants of any type while with the
+ * scope search we return only those which can be invoked on a variable (member,
+ * method, etc.). Members of the types type_tag inherits from are included, those
+ * of other types than type_tag are searched in their own file or the global tags. */
+static GPtrArray *
+find_scope_members_tags (const GPtrArray *all, TMTag *type_tag, gboolean namespace)
+{
+	TMTagType member_types = tm_tag_max_t & ~(TM_TYPE_WITH_MEMBERS | tm_tag_typedef_t);
+	TMTagAttrType sort_attr[] = {tm_tag_attr_name_t, 0};
+	GPtrArray *tags = g_ptr_array_new();
+	GPtrArray *types = g_ptr_array_new();
+	GHashTable *visited = NULL;
+	guint i;
+
+	if (namespace)
+		member_types = tm_tag_max_t;
+
+	/* walk the class hierarchy breadth first, visiting every type only once in case
+	 * the inheritance is cyclic */
+	g_ptr_array_add(types, type_tag);
+	for (i = 0; i < types->len; i++)
+	{
+		TMTag *tag = types->pdata[i];
+		gchar **parents = tag_index_get_parents(tag);
+
+		for (; parents && *parents; parents++)
+		{
+			TMTag *parent = find_parent_type(*parents, tag);
+
+			if (!parent)
+				continue;
+			if (!visited)
+			{
+				visited = g_hash_table_new(g_direct_hash, g_direct_equal);
+				g_hash_table_add(visited, type_tag);
+			}
+			if (!g_hash_table_contains(visited, parent))
+			{
+				g_hash_table_add(visited, parent);
+				g_ptr_array_add(types, parent);
+			}
+		}
+	}
+
+	/* add the members of the most distant ancestors first - the sort is stable so
+	 * members of derived types end up last among those with the same name and are
+	 * the ones tm_tags_dedup() keeps, overriding those they inherit */
+	for (i = types->len; i > 1; i--)
+	{
+		TMTag *tag = types->pdata[i - 1];
+
+		add_scope_members_tags(tags, tag->file ? tag->file->tags_array : theWorkspace->global_tags,
+			tag, member_types, namespace);
+	}
+	add_scope_members_tags(tags, all, type_tag, member_types, namespace);
+	if (types->len > 1)
+		tm_tags_sort(tags, sort_attr, FALSE, FALSE);
+
+	g_ptr_array_free(types, TRUE);
+	if (visited)
+		g_hash_table_destroy(visited);
 
 	if (tags->len == 0)
 	{
@@ -1097,59 +1903,3 @@ void tm_workspace_dump(void)
 	}
 }
 #endif /* TM_DEBUG */
-
-
-#if 0
-
-/* Returns a list of parent classes for the given class name
- @param name Name of the class
- @return A GPtrArray of TMTag pointers (includes the TMTag for the class) */
-static const GPtrArray *tm_workspace_get_parents(const gchar *name)
-{
-	static TMTagAttrType type[] = { tm_tag_attr_name_t, tm_tag_attr_none_t };
-	static GPtrArray *parents = NULL;
-	const GPtrArray *matches;
-	guint i = 0;
-	guint j;
-	gchar **klasses;
-	gchar **klass;
-	TMTag *tag;
-
-	g_return_val_if_fail(name && isalpha(*name),NULL);
-
-	if (NULL == parents)
-		parents = g_ptr_array_new();
-	else
-		g_ptr_array_set_size(parents, 0);
-	matches = tm_workspace_find(name, NULL, tm_tag_class_t, type, -1);
-	if ((NULL == matches) || (0 == matches->len))
-		return NULL;
-	g_ptr_array_add(parents, matches->pdata[0]);
-	while (i < parents->len)
-	{
-		tag = TM_TAG(parents->pdata[i]);
-		if ((NULL != tag->inheritance) && (isalpha(tag->inheritance[0])))
-		{
-			klasses = g_strsplit(tag->inheritance, ",", 10);
-			for (klass = klasses; (NULL != *klass); ++ klass)
-			{
-				for (j=0; j < parents->len; ++j)
-				{
-					if (0 == strcmp(*klass, TM_TAG(parents->pdata[j])->name))
-						break;
-				}
-				if (parents->len == j)
-				{
-					matches = tm_workspace_find(*klass, NULL, tm_tag_class_t, type, -1);
-					if ((NULL != matches) && (0 < matches->len))
-						g_ptr_array_add(parents, matches->pdata[0]);
-				}
-			}
-			g_strfreev(klasses);
-		}
-		++ i;
-	}
-	return parents;
-}
-
-#endif
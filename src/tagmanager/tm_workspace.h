@@ -49,14 +49,22 @@ const TMWorkspace *tm_get_workspace(void);
 
 gboolean tm_workspace_load_global_tags(const char *tags_file, TMParserType mode);
 
+GPtrArray *tm_workspace_read_global_tags(const char *tags_file, TMParserType mode);
+
+void tm_workspace_add_global_tags(GPtrArray *file_tags);
+
 gboolean tm_workspace_create_global_tags(const char *pre_process, const char **includes,
-	int includes_count, const char *tags_file, TMParserType lang);
+	int includes_count, const char *tags_file, TMParserType lang, const char *cache_dir);
 
 GPtrArray *tm_workspace_find(const char *name, const char *scope, TMTagType type,
 	TMTagAttrType *attrs, TMParserType lang);
 
 GPtrArray *tm_workspace_find_prefix(const char *prefix, TMParserType lang, guint max_num);
 
+GPtrArray *tm_workspace_find_global_typenames(TMParserType lang);
+
+GPtrArray *tm_workspace_find_occurrences(const gchar *token);
+
 GPtrArray *tm_workspace_find_scope_members (TMSourceFile *source_file, const char *name,
 	gboolean function, gboolean member, const gchar *current_scope, gboolean search_namespace);
 
@@ -137,6 +137,7 @@ static void set_statusbar(const gchar *text, gboolean allow_override)
 {
 	static guint id = 0;
 	static glong last_time = 0;
+	static gchar *last_text = NULL;
 	GTimeVal timeval;
 	const gint GEANY_STATUS_TIMEOUT = 1;
 
@@ -149,17 +150,17 @@ static void set_statusbar(const gchar *text, gboolean allow_override)
 	g_get_current_time(&timeval);
 
 	if (! allow_override)
-	{
-		gtk_statusbar_pop(GTK_STATUSBAR(ui_widgets.statusbar), id);
-		gtk_statusbar_push(GTK_STATUSBAR(ui_widgets.statusbar), id, text);
 		last_time = timeval.tv_sec;
-	}
-	else
-	if (timeval.tv_sec > last_time + GEANY_STATUS_TIMEOUT)
-	{
-		gtk_statusbar_pop(GTK_STATUSBAR(ui_widgets.statusbar), id);
-		gtk_statusbar_push(GTK_STATUSBAR(ui_widgets.statusbar), id, text);
-	}
+	else if (timeval.tv_sec <= last_time + GEANY_STATUS_TIMEOUT)
+		return;
+	/* the statistics often don't change, e.g. when only the selection changed and the template
+	 * has no %s, so avoid relayouting the statusbar then */
+	else if (g_strcmp0(text, last_text) == 0)
+		return;
+
+	gtk_statusbar_pop(GTK_STATUSBAR(ui_widgets.statusbar), id);
+	gtk_statusbar_push(GTK_STATUSBAR(ui_widgets.statusbar), id, text);
+	SETPTR(last_text, g_strdup(text));
 }
 
 
@@ -186,22 +187,126 @@ void ui_set_statusbar(gboolean log, const gchar *format, ...)
 }
 
 
+/* statusbar template fields which need to be computed before formatting */
+enum
+{
+	STATS_FIELD_LINE	= 1 << 0,	/* %l */
+	STATS_FIELD_COLUMN	= 1 << 1	/* %c, %C */
+};
+
+/* Computing the column walks the line from its start, which is slow for long lines e.g. when
+ * holding down an arrow key, so the last column is kept to continue from it if possible. */
+#define STATS_COLUMN_MAX_DISTANCE 256
+
+static struct
+{
+	gchar *template;		/* template the fields were parsed from */
+	guint fields;			/* STATS_FIELD_* used by template */
+	ScintillaObject *sci;	/* editor of the cached column */
+	gint pos;				/* position of the cached column, or -1 if none */
+	gint col;				/* column at pos, without virtual space */
+	gint tab_width;			/* tab width col was computed with */
+}
+stats_cache = {NULL, 0, NULL, -1, 0, 0};
+
+
+static const gchar *get_statusbar_template(void)
+{
+	if (!EMPTY(ui_prefs.statusbar_template))
+		return ui_prefs.statusbar_template;
+	else
+		return _(DEFAULT_STATUSBAR_TEMPLATE);
+}
+
+
+static guint get_statusbar_fields(const gchar *fmt)
+{
+	if (g_strcmp0(fmt, stats_cache.template) != 0)
+	{
+		const gchar *expos;
+
+		stats_cache.fields = 0;
+		for (expos = strchr(fmt, '%'); expos && expos[1]; expos = strchr(expos + 2, '%'))
+		{
+			switch (expos[1])
+			{
+				case 'l':
+					stats_cache.fields |= STATS_FIELD_LINE;
+					break;
+				case 'c':
+				case 'C':
+					stats_cache.fields |= STATS_FIELD_COLUMN;
+					break;
+			}
+		}
+		SETPTR(stats_cache.template, g_strdup(fmt));
+	}
+	return stats_cache.fields;
+}
+
+
+/* Same as sci_get_col_from_position() but continues from the cached column when pos follows it
+ * closely on the same line, which is only done for ASCII text to count like Scintilla does. */
+static gint get_statusbar_column(ScintillaObject *sci, gint pos)
+{
+	gint tab_width = sci_get_tab_width(sci);
+	gint col = -1;
+
+	if (stats_cache.sci == sci && stats_cache.tab_width == tab_width &&
+		stats_cache.pos >= 0 && stats_cache.pos <= pos &&
+		pos - stats_cache.pos <= STATS_COLUMN_MAX_DISTANCE)
+	{
+		gint i;
+
+		col = stats_cache.col;
+		for (i = stats_cache.pos; i < pos && col >= 0; i++)
+		{
+			gchar c = sci_get_char_at(sci, i);
+
+			if (c == '\t')
+				col = (col / tab_width + 1) * tab_width;
+			else if (c == '\r' || c == '\n' || (guchar) c >= 0x80)
+				col = -1;
+			else
+				col++;
+		}
+	}
+	if (col < 0)
+		col = sci_get_col_from_position(sci, pos);
+
+	stats_cache.sci = sci;
+	stats_cache.pos = pos;
+	stats_cache.col = col;
+	stats_cache.tab_width = tab_width;
+	return col;
+}
+
+
+/* Invalidates the cached column when text before it was changed. */
+void ui_update_statusbar_on_modify(GeanyDocument *doc, gint pos)
+{
+	if (stats_cache.sci == doc->editor->sci && pos < stats_cache.pos)
+		stats_cache.pos = -1;
+}
+
+
+static gboolean is_line_start(ScintillaObject *sci, gint pos)
+{
+	return sci_get_position_from_line(sci, sci_get_line_from_position(sci, pos)) == pos;
+}
+
+
 /* note: some comments below are for translators */
 static gchar *create_statusbar_statistics(GeanyDocument *doc,
 	guint line, guint vcol, guint pos)
 {
 	const gchar *cur_tag;
-	const gchar *fmt;
+	const gchar *fmt = get_statusbar_template();
 	const gchar *expos;	/* % expansion position */
 	const gchar sp[] = "      ";
 	GString *stats_str;
 	ScintillaObject *sci = doc->editor->sci;
 
-	if (!EMPTY(ui_prefs.statusbar_template))
-		fmt = ui_prefs.statusbar_template;
-	else
-		fmt = _(DEFAULT_STATUSBAR_TEMPLATE);
-
 	stats_str = g_string_sized_new(120);
 
 	while ((expos = strchr(fmt, '%')) != NULL)
@@ -231,10 +336,8 @@ static gchar *create_statusbar_statistics(GeanyDocument *doc,
 			{
 				gint len = sci_get_selected_text_length(sci) - 1;
 				/* check if whole lines are selected */
-				if (!len || sci_get_col_from_position(sci,
-						sci_get_selection_start(sci)) != 0 ||
-					sci_get_col_from_position(sci,
-						sci_get_selection_end(sci)) != 0)
+				if (!len || !is_line_start(sci, sci_get_selection_start(sci)) ||
+					!is_line_start(sci, sci_get_selection_end(sci)))
 					g_string_append_printf(stats_str, "%d", len);
 				else /* L = lines */
 					g_string_append_printf(stats_str, _("%dL"),
@@ -305,6 +408,23 @@ static gchar *create_statusbar_statistics(GeanyDocument *doc,
 				g_string_append_printf(stats_str, "%d",
 					sci_get_style_at(doc->editor->sci, pos));
 				break;
+			case 'u':
+			{
+				gchar *size = g_format_size(sci_get_undo_memory_usage(doc->editor->sci));
+
+				g_string_append(stats_str, size);
+				g_free(size);
+				break;
+			}
+			case 'H':
+			{
+				gulong hits, misses;
+
+				sci_get_position_cache_stats(doc->editor->sci, &hits, &misses);
+				g_string_append_printf(stats_str, "%lu%%",
+					hits + misses > 0 ? (gulong) (100.0 * hits / (hits + misses)) : 0);
+				break;
+			}
 			default:
 				g_string_append_len(stats_str, expos, 1);
 		}
@@ -335,21 +455,25 @@ void ui_update_statusbar(GeanyDocument *doc, gint pos)
 
 	if (doc != NULL)
 	{
-		guint line, vcol;
+		ScintillaObject *sci = doc->editor->sci;
+		guint fields = get_statusbar_fields(get_statusbar_template());
+		guint line = 0, vcol = 0;
 		gchar *stats_str;
 
 		if (pos == -1)
-			pos = sci_get_current_position(doc->editor->sci);
-		line = sci_get_line_from_position(doc->editor->sci, pos);
-
-		/* Add temporary fix for sci infinite loop in Document::GetColumn(int)
-		 * when current pos is beyond document end (can occur when removing
-		 * blocks of selected lines especially esp. brace sections near end of file). */
-		if (pos <= sci_get_length(doc->editor->sci))
-			vcol = sci_get_col_from_position(doc->editor->sci, pos);
-		else
-			vcol = 0;
-		vcol += sci_get_cursor_virtual_space(doc->editor->sci);
+			pos = sci_get_current_position(sci);
+		if (fields & STATS_FIELD_LINE)
+			line = sci_get_line_from_position(sci, pos);
+
+		if (fields & STATS_FIELD_COLUMN)
+		{
+			/* Add temporary fix for sci infinite loop in Document::GetColumn(int)
+			 * when current pos is beyond document end (can occur when removing
+			 * blocks of selected lines especially esp. brace sections near end of file). */
+			if (pos <= sci_get_length(sci))
+				vcol = get_statusbar_column(sci, pos);
+			vcol += sci_get_cursor_virtual_space(sci);
+		}
 
 		stats_str = create_statusbar_statistics(doc, line, vcol, pos);
 
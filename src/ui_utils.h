@@ -281,6 +281,8 @@ void ui_add_config_file_menu_item(const gchar *real_path, const gchar *label,
 
 void ui_update_statusbar(GeanyDocument *doc, gint pos);
 
+void ui_update_statusbar_on_modify(GeanyDocument *doc, gint pos);
+
 
 /* This sets the window title according to the current filename. */
 void ui_set_window_title(GeanyDocument *doc);
@@ -631,23 +631,6 @@ gchar *utils_remove_ext_from_filename(const gchar *filename)
 }
 
 
-gchar utils_brace_opposite(gchar ch)
-{
-	switch (ch)
-	{
-		case '(': return ')';
-		case ')': return '(';
-		case '[': return ']';
-		case ']': return '[';
-		case '{': return '}';
-		case '}': return '{';
-		case '<': return '>';
-		case '>': return '<';
-		default: return '\0';
-	}
-}
-
-
 /* Checks whether the given file can be written. locale_filename is expected in locale encoding.
  * Returns 0 if it can be written, otherwise it returns errno */
 gint utils_is_file_writable(const gchar *locale_filename)
@@ -0,0 +1,215 @@
+/*
+ *      sci_bench.cxx - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* Benchmark of Scintilla's document operations used by Geany, run on a Document
+ * without any widget. Every measurement is printed to stdout as one JSON object per
+ * line in the same format as tests/tagmanager/tm_bench:
+ *
+ * {"benchmark": "find/match_case/utf8", "unit": "bytes", "ops": 104857600,
+ *  "seconds": 0.010000, "ops_per_sec": 10485760000.0, "peak_rss_kb": 23456}
+ *
+ * Usage: sci_bench [SIZE_MB] */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+#ifndef _WIN32
+# include <sys/resource.h>
+#endif
+
+#include "Platform.h"
+
+#include "ILexer.h"
+#include "Scintilla.h"
+
+#include "CharacterCategory.h"
+#include "Position.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "CellBuffer.h"
+#include "PerLine.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+
+#ifdef SCI_NAMESPACE
+using namespace Scintilla;
+#endif
+
+static long PeakRSSKB() {
+#ifndef _WIN32
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+# ifdef __APPLE__
+		return usage.ru_maxrss / 1024;
+# else
+		return usage.ru_maxrss;
+# endif
+#endif
+	return -1;
+}
+
+static void Report(const char *benchmark, const char *unit, double ops, double seconds) {
+	printf("{\"benchmark\": \"%s\", \"unit\": \"%s\", \"ops\": %.0f, \"seconds\": %.6f, "
+		"\"ops_per_sec\": %.1f, \"peak_rss_kb\": %ld}\n",
+		benchmark, unit, ops, seconds, seconds > 0 ? ops / seconds : 0.0, PeakRSSKB());
+	fflush(stdout);
+}
+
+static double SecondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// A document of sizeMB megabytes of source-like text with the gap in the middle
+static Document *CreateDocument(int sizeMB, int codePage) {
+	static const char line[] =
+		"\tfor (i = 0; i < len; i++) sum += values[i] * factor; /* Lorem ipsum */\n";
+	Document *doc = new Document();
+	doc->dbcsCodePage = codePage;
+	CaseFolderTable *pcf = new CaseFolderTable();
+	pcf->StandardASCII();
+	doc->SetCaseFolder(pcf);
+
+	std::string chunk;
+	while (chunk.length() < 1024 * 1024)
+		chunk += line;
+	chunk.resize(1024 * 1024);
+	for (int i = 0; i < sizeMB; i++)
+		doc->InsertString(doc->Length(), chunk.c_str(), static_cast<int>(chunk.length()));
+	doc->InsertString(doc->Length() / 2, " ", 1);
+	return doc;
+}
+
+static void BenchFind(Document *doc, const char *name, const char *search, int flags) {
+	int length = static_cast<int>(strlen(search));
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	const long pos = doc->FindText(0, doc->Length(), search, flags, &length);
+	const double seconds = SecondsSince(start);
+	if (pos != -1)
+		fprintf(stderr, "%s: unexpected match at %ld\n", name, pos);
+	Report(name, "bytes", doc->Length(), seconds);
+}
+
+// A fully styled document of sizeMB megabytes of nested braces like minified JSON,
+// all inside one pair of brackets
+static Document *CreateBracesDocument(int sizeMB, int codePage) {
+	static const char item[] = "{\"id\":[1,2,{\"a\":\"b\"}],\"v\":{\"w\":[3,(4)]}},";
+	Document *doc = new Document();
+	doc->dbcsCodePage = codePage;
+
+	std::string chunk;
+	while (chunk.length() < 1024 * 1024)
+		chunk += item;
+	doc->InsertString(0, "[", 1);
+	for (int i = 0; i < sizeMB; i++)
+		doc->InsertString(doc->Length(), chunk.c_str(), static_cast<int>(chunk.length()));
+	doc->InsertString(doc->Length(), "]", 1);
+	doc->StartStyling(0, 0);
+	doc->SetStyleFor(doc->Length(), 0);
+	return doc;
+}
+
+// Matches the braces next to positions spread over the document like when moving the
+// caret through it, the outer brackets, and the outer brackets after each edit
+static void BenchBraceMatch(Document *doc, const char *codePageName) {
+	const int queries = 1000;
+	const int step = doc->Length() / queries;
+	std::string name;
+	int found = 0;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int i = 0; i < queries; i++) {
+		for (int pos = 1 + i * step; pos < doc->Length(); pos++) {
+			if (strchr("()[]{}", doc->CharAt(pos))) {
+				found += doc->BraceMatch(pos, 0) >= 0;
+				break;
+			}
+		}
+	}
+	name = std::string("brace_match/") + codePageName;
+	Report(name.c_str(), "matches", queries, SecondsSince(start));
+
+	const int outerQueries = 100;
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < outerQueries; i++)
+		found += doc->BraceMatch((i % 2) ? doc->Length() - 1 : 0, 0) >= 0;
+	name = std::string("brace_match_outer/") + codePageName;
+	Report(name.c_str(), "matches", outerQueries, SecondsSince(start));
+
+	const int edits = 100;
+	double seconds = 0;
+	for (int i = 0; i < edits; i++) {
+		const int pos = doc->Length() - 1 - (i + 1) * step;
+		doc->InsertString(pos, " ", 1);
+		doc->StartStyling(pos, 0);
+		doc->SetStyleFor(doc->Length() - pos, 0);
+		start = std::chrono::steady_clock::now();
+		found += doc->BraceMatch(doc->Length() - 1, 0) >= 0;
+		seconds += SecondsSince(start);
+	}
+	name = std::string("brace_match_edit/") + codePageName;
+	Report(name.c_str(), "matches", edits, seconds);
+
+	if (found != queries + outerQueries + edits)
+		fprintf(stderr, "%s: %d unmatched braces\n", codePageName, queries + outerQueries + edits - found);
+}
+
+int main(int argc, char **argv) {
+	const int sizeMB = (argc > 1) ? Platform::Maximum(atoi(argv[1]), 1) : 100;
+	const struct {
+		const char *name;
+		int codePage;
+	} codePages[] = {
+		{ "utf8", SC_CP_UTF8 },
+		{ "8bit", 0 },
+	};
+
+	for (size_t i = 0; i < sizeof(codePages) / sizeof(codePages[0]); i++) {
+		Document *doc = CreateDocument(sizeMB, codePages[i].codePage);
+		std::string name;
+
+		// search for text which isn't there to scan the whole document, the first
+		// character is frequent to also measure the cost of rejecting candidates
+		name = std::string("find/match_case/") + codePages[i].name;
+		BenchFind(doc, name.c_str(), "sum_total", SCFIND_MATCHCASE);
+		name = std::string("find/match_case_rare/") + codePages[i].name;
+		BenchFind(doc, name.c_str(), "@notfound", SCFIND_MATCHCASE);
+		name = std::string("find/ignore_case/") + codePages[i].name;
+		BenchFind(doc, name.c_str(), "Sum_Total", 0);
+		name = std::string("find/whole_word/") + codePages[i].name;
+		BenchFind(doc, name.c_str(), "valu", SCFIND_MATCHCASE | SCFIND_WHOLEWORD);
+
+		doc->Release();
+
+		doc = CreateBracesDocument(sizeMB, codePages[i].codePage);
+		BenchBraceMatch(doc, codePages[i].name);
+		doc->Release();
+	}
+	return 0;
+}
@@ -0,0 +1,693 @@
+/*
+ *      tm_bench.c - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* Benchmark of the tag manager without the rest of Geany.
+ *
+ * Times parsing of the files of the given directories (e.g. tests/ctags) per
+ * language and of a large synthetic C file and header, then workspace operations
+ * on synthetic workspaces of several sizes, member lookups in a deep class
+ * hierarchy loaded as global tags and lookups in global tags of several
+ * languages. Every measurement is printed to stdout as one JSON
+ * object per line:
+ *
+ * {"benchmark": "workspace_add/1000", "unit": "files", "ops": 1000,
+ *  "seconds": 0.123456, "ops_per_sec": 8100.0, "peak_rss_kb": 23456}
+ *
+ * peak_rss_kb is the peak resident memory of the process so far, -1 if unknown. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "tm_source_file.h"
+#include "tm_tag.h"
+#include "tm_workspace.h"
+
+#include "parse.h" /* for getFileLanguage() */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef G_OS_UNIX
+# include <sys/resource.h>
+#endif
+
+
+static gint iterations = 3;
+static gint queries = 10000;
+static gint functions_per_file = 8;
+static gint synthetic_blocks = 20000;
+static gint hierarchy_depth = 12;
+static gint hierarchy_width = 1000;
+static gint language_tags = 50000;
+static gchar *scales = NULL;
+
+static GOptionEntry entries[] =
+{
+	{ "iterations", 'i', 0, G_OPTION_ARG_INT, &iterations,
+		"Number of times every file is parsed (default 3)", "N" },
+	{ "queries", 'q', 0, G_OPTION_ARG_INT, &queries,
+		"Number of queries of every workspace search benchmark (default 10000)", "N" },
+	{ "functions", 'f', 0, G_OPTION_ARG_INT, &functions_per_file,
+		"Number of functions in every synthetic workspace file (default 8)", "N" },
+	{ "blocks", 'b', 0, G_OPTION_ARG_INT, &synthetic_blocks,
+		"Number of code blocks of the large synthetic file (default 20000)", "N" },
+	{ "depth", 'd', 0, G_OPTION_ARG_INT, &hierarchy_depth,
+		"Depth of the synthetic class hierarchy of the global tags (default 12)", "N" },
+	{ "width", 'w', 0, G_OPTION_ARG_INT, &hierarchy_width,
+		"Number of classes on every level of the class hierarchy (default 1000)", "N" },
+	{ "language-tags", 'l', 0, G_OPTION_ARG_INT, &language_tags,
+		"Number of global tags of every language of the mixed languages benchmark "
+		"(default 50000)", "N" },
+	{ "scales", 's', 0, G_OPTION_ARG_STRING, &scales,
+		"Comma separated numbers of files of the synthetic workspaces "
+		"(default 1000,10000,100000)", "LIST" },
+	{ NULL, 0, 0, 0, NULL, NULL, NULL }
+};
+
+
+static glong get_peak_rss_kb(void)
+{
+#ifdef G_OS_UNIX
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+# ifdef __APPLE__
+		return usage.ru_maxrss / 1024;
+# else
+		return usage.ru_maxrss;
+# endif
+	}
+#endif
+	return -1;
+}
+
+
+static void report(const gchar *benchmark, const gchar *unit, guint64 ops, gdouble seconds)
+{
+	printf("{\"benchmark\": \"%s\", \"unit\": \"%s\", \"ops\": %" G_GUINT64_FORMAT
+		", \"seconds\": %.6f, \"ops_per_sec\": %.1f, \"peak_rss_kb\": %ld}\n",
+		benchmark, unit, ops, seconds, seconds > 0 ? ops / seconds : 0.0, get_peak_rss_kb());
+	fflush(stdout);
+}
+
+
+/* Appends a block of C code with a struct, a typedef, a macro and functions using
+ * names unique to the block as well as names shared by all blocks. */
+static void append_c_block(GString *str, guint block, guint functions)
+{
+	guint i;
+
+	g_string_append_printf(str,
+		"typedef struct bench_struct_%u\n"
+		"{\n"
+		"\tint member_%u_a;\n"
+		"\tchar *member_%u_b;\n"
+		"\tdouble member_shared;\n"
+		"} BenchStruct%u;\n"
+		"\n"
+		"#define BENCH_MACRO_%u(x) ((x) + %u)\n"
+		"\n", block, block, block, block, block, block);
+
+	for (i = 0; i < functions; i++)
+	{
+		g_string_append_printf(str,
+			"int bench_function_%u_%u(BenchStruct%u *s, int n)\n"
+			"{\n"
+			"\tint i, sum = 0;\n"
+			"\n"
+			"\tfor (i = 0; i < n; i++)\n"
+			"\t\tsum += BENCH_MACRO_%u(i) + s->member_%u_a + bench_common(i);\n"
+			"\treturn sum;\n"
+			"}\n"
+			"\n", block, i, block, block, block);
+	}
+	g_string_append(str, "static int bench_common(int x)\n{\n\treturn x;\n}\n\n");
+}
+
+
+/* Appends a block of a header in the style of GLib and GTK: documentation
+ * comments, prototypes with attribute macros, strings and conditionals. */
+static void append_header_block(GString *str, guint block)
+{
+	g_string_append_printf(str,
+		"/**\n"
+		" * bench_object_%u_set_label:\n"
+		" * @object: a #BenchObject%u\n"
+		" * @label: (nullable): the text of the label, e.g. \"name: <b>%u</b>\"\n"
+		" *\n"
+		" * Sets the label of @object.  If @label is %%NULL, the label is removed\n"
+		" * and the object is resized to fit its other contents, see\n"
+		" * bench_object_%u_get_label() and the #BenchObject%u:label property.\n"
+		" *\n"
+		" * Since: 3.%u\n"
+		" */\n"
+		"BENCH_AVAILABLE_IN_ALL\n"
+		"void bench_object_%u_set_label (BenchObject%u *object,\n"
+		"                                const char   *label);\n"
+		"// returns the label, or \"\" if there is none\n"
+		"BENCH_AVAILABLE_IN_ALL\n"
+		"const char *bench_object_%u_get_label (BenchObject%u *object);\n"
+		"#ifdef BENCH_ENABLE_DEBUG\n"
+		"#define BENCH_OBJECT_%u_DEBUG(o) g_debug (\"object %%p: '%%s'\", (o), \\\n"
+		"\tbench_object_%u_get_label (o))\n"
+		"#else\n"
+		"#define BENCH_OBJECT_%u_DEBUG(o) /* nothing */\n"
+		"#endif\n"
+		"\n", block, block, block, block, block, block % 24, block, block, block, block,
+		block, block, block);
+}
+
+
+static gboolean write_file(const gchar *file_name, GString *contents)
+{
+	GError *error = NULL;
+
+	if (!g_file_set_contents(file_name, contents->str, contents->len, &error))
+	{
+		g_printerr("Cannot write %s: %s\n", file_name, error->message);
+		g_error_free(error);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+
+static void bench_corpus(const gchar *dir_name)
+{
+	GHashTable *langs = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+		(GDestroyNotify) g_ptr_array_unref);
+	GHashTableIter iter;
+	gpointer key, value;
+	GError *error = NULL;
+	const gchar *name;
+	GDir *dir;
+	GTimer *timer;
+	guint64 total_bytes = 0;
+	gdouble total_seconds = 0;
+
+	dir = g_dir_open(dir_name, 0, &error);
+	if (!dir)
+	{
+		g_printerr("Cannot open %s: %s\n", dir_name, error->message);
+		g_error_free(error);
+		g_hash_table_destroy(langs);
+		return;
+	}
+
+	/* group the files by their language, detected by ctags from the file name */
+	while ((name = g_dir_read_name(dir)) != NULL)
+	{
+		gchar *file_name = g_build_filename(dir_name, name, NULL);
+		TMParserType lang = getFileLanguage(file_name);
+		TMSourceFile *source_file = NULL;
+
+		if (lang >= 0 && !g_str_has_suffix(name, ".tags"))
+			source_file = tm_source_file_new(file_name, tm_source_file_get_lang_name(lang));
+		if (source_file)
+		{
+			const gchar *lang_name = tm_source_file_get_lang_name(lang);
+			GPtrArray *source_files = g_hash_table_lookup(langs, lang_name);
+
+			if (!source_files)
+			{
+				source_files = g_ptr_array_new_with_free_func((GDestroyNotify) tm_source_file_free);
+				g_hash_table_insert(langs, (gpointer) lang_name, source_files);
+			}
+			g_ptr_array_add(source_files, source_file);
+		}
+		g_free(file_name);
+	}
+	g_dir_close(dir);
+
+	timer = g_timer_new();
+	g_hash_table_iter_init(&iter, langs);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		GPtrArray *source_files = value;
+		gchar *benchmark;
+		gdouble seconds;
+		guint64 bytes = 0;
+		guint i;
+		gint n;
+
+		for (i = 0; i < source_files->len; i++)
+		{
+			GStatBuf st;
+
+			if (g_stat(TM_SOURCE_FILE(source_files->pdata[i])->file_name, &st) == 0)
+				bytes += (guint64) st.st_size * iterations;
+		}
+		total_bytes += bytes;
+
+		g_timer_start(timer);
+		for (n = 0; n < iterations; n++)
+		{
+			for (i = 0; i < source_files->len; i++)
+				tm_source_file_parse(source_files->pdata[i], NULL, 0, FALSE);
+		}
+		seconds = g_timer_elapsed(timer, NULL);
+		total_seconds += seconds;
+
+		benchmark = g_strconcat("parse/", (const gchar *) key, NULL);
+		report(benchmark, "files", (guint64) source_files->len * iterations, seconds);
+		g_free(benchmark);
+
+		/* the parser throughput, independent of the size of its sample files */
+		benchmark = g_strconcat("parse_bytes/", (const gchar *) key, NULL);
+		report(benchmark, "bytes", bytes, seconds);
+		g_free(benchmark);
+	}
+	report("parse/corpus", "bytes", total_bytes, total_seconds);
+
+	g_timer_destroy(timer);
+	g_hash_table_destroy(langs);
+}
+
+
+static void bench_synthetic_parse(const gchar *tmp_dir)
+{
+	gchar *file_name = g_build_filename(tmp_dir, "synthetic.c", NULL);
+	GString *str = g_string_new(NULL);
+	TMSourceFile *source_file;
+	GTimer *timer;
+	gint i;
+
+	for (i = 0; i < synthetic_blocks; i++)
+		append_c_block(str, i, 4);
+
+	if (write_file(file_name, str) && (source_file = tm_source_file_new(file_name, "C")) != NULL)
+	{
+		timer = g_timer_new();
+		for (i = 0; i < iterations; i++)
+			tm_source_file_parse(source_file, (guchar *) str->str, str->len, TRUE);
+		report("parse/synthetic", "bytes", (guint64) str->len * iterations,
+			g_timer_elapsed(timer, NULL));
+		g_timer_destroy(timer);
+		tm_source_file_free(source_file);
+	}
+
+	g_unlink(file_name);
+	g_free(file_name);
+	g_string_free(str, TRUE);
+}
+
+
+/* Parses a large header mostly made of comments, which the C preprocessor of
+ * ctags has to skip. */
+static void bench_synthetic_header(const gchar *tmp_dir)
+{
+	gchar *file_name = g_build_filename(tmp_dir, "synthetic.h", NULL);
+	GString *str = g_string_new(NULL);
+	TMSourceFile *source_file;
+	GTimer *timer;
+	gint i;
+
+	for (i = 0; i < synthetic_blocks; i++)
+		append_header_block(str, i);
+
+	if (write_file(file_name, str) && (source_file = tm_source_file_new(file_name, "C")) != NULL)
+	{
+		timer = g_timer_new();
+		for (i = 0; i < iterations; i++)
+			tm_source_file_parse(source_file, (guchar *) str->str, str->len, TRUE);
+		report("parse/synthetic_header", "bytes", (guint64) str->len * iterations,
+			g_timer_elapsed(timer, NULL));
+		g_timer_destroy(timer);
+		tm_source_file_free(source_file);
+	}
+
+	g_unlink(file_name);
+	g_free(file_name);
+	g_string_free(str, TRUE);
+}
+
+
+static void bench_workspace(const gchar *tmp_dir, guint file_count)
+{
+	gchar *dir_name = g_strdup_printf("%s%cworkspace-%u", tmp_dir, G_DIR_SEPARATOR, file_count);
+	GPtrArray *source_files = g_ptr_array_new();
+	GString *str = g_string_new(NULL);
+	TMParserType lang = tm_source_file_get_named_lang("C");
+	GRand *rand = g_rand_new_with_seed(42);
+	GTimer *timer = g_timer_new();
+	gchar benchmark[64];
+	guint i;
+
+	if (g_mkdir_with_parents(dir_name, 0755) != 0)
+	{
+		g_printerr("Cannot create %s\n", dir_name);
+		goto cleanup;
+	}
+
+	for (i = 0; i < file_count; i++)
+	{
+		gchar *file_name = g_strdup_printf("%s%cfile%u.c", dir_name, G_DIR_SEPARATOR, i);
+		TMSourceFile *source_file;
+
+		g_string_truncate(str, 0);
+		append_c_block(str, i, functions_per_file);
+		if (write_file(file_name, str) &&
+			(source_file = tm_source_file_new(file_name, "C")) != NULL)
+			g_ptr_array_add(source_files, source_file);
+		g_free(file_name);
+	}
+	if (source_files->len == 0)
+		goto cleanup;
+
+	g_timer_start(timer);
+	tm_workspace_add_source_files(source_files);
+	g_snprintf(benchmark, sizeof benchmark, "workspace_add/%u", file_count);
+	report(benchmark, "files", source_files->len, g_timer_elapsed(timer, NULL));
+
+	/* reparsing the edited document while the workspace is big */
+	g_string_truncate(str, 0);
+	append_c_block(str, 0, functions_per_file);
+	g_timer_start(timer);
+	for (i = 0; i < 100; i++)
+		tm_workspace_update_source_file_buffer(source_files->pdata[0], (guchar *) str->str, str->len);
+	g_snprintf(benchmark, sizeof benchmark, "workspace_update_file/%u", file_count);
+	report(benchmark, "updates", 100, g_timer_elapsed(timer, NULL));
+
+	g_timer_start(timer);
+	for (i = 0; i < (guint) queries; i++)
+	{
+		gchar name[64];
+		GPtrArray *tags;
+
+		g_snprintf(name, sizeof name, "bench_function_%u_%u",
+			g_rand_int_range(rand, 0, source_files->len),
+			g_rand_int_range(rand, 0, MAX(functions_per_file, 1)));
+		tags = tm_workspace_find(name, NULL, tm_tag_max_t, NULL, lang);
+		g_ptr_array_free(tags, TRUE);
+	}
+	g_snprintf(benchmark, sizeof benchmark, "workspace_find/%u", file_count);
+	report(benchmark, "queries", queries, g_timer_elapsed(timer, NULL));
+
+	g_timer_start(timer);
+	for (i = 0; i < (guint) queries; i++)
+	{
+		gchar prefix[64];
+		GPtrArray *tags;
+
+		g_snprintf(prefix, sizeof prefix, "bench_function_%u",
+			g_rand_int_range(rand, 0, source_files->len));
+		tags = tm_workspace_find_prefix(prefix, lang, 100);
+		g_ptr_array_free(tags, TRUE);
+	}
+	g_snprintf(benchmark, sizeof benchmark, "workspace_find_prefix/%u", file_count);
+	report(benchmark, "queries", queries, g_timer_elapsed(timer, NULL));
+
+	g_timer_start(timer);
+	for (i = 0; i < (guint) queries; i++)
+	{
+		guint n = g_rand_int_range(rand, 0, source_files->len);
+		gchar name[64];
+		GPtrArray *tags;
+
+		g_snprintf(name, sizeof name, "BenchStruct%u", n);
+		tags = tm_workspace_find_scope_members(source_files->pdata[n], name,
+			FALSE, FALSE, "", FALSE);
+		if (tags)
+			g_ptr_array_free(tags, TRUE);
+	}
+	g_snprintf(benchmark, sizeof benchmark, "workspace_find_scope_members/%u", file_count);
+	report(benchmark, "queries", queries, g_timer_elapsed(timer, NULL));
+
+	g_timer_start(timer);
+	tm_workspace_remove_source_files(source_files);
+	g_snprintf(benchmark, sizeof benchmark, "workspace_remove/%u", file_count);
+	report(benchmark, "files", source_files->len, g_timer_elapsed(timer, NULL));
+
+cleanup:
+	for (i = 0; i < source_files->len; i++)
+		tm_source_file_free(source_files->pdata[i]);
+	g_ptr_array_free(source_files, TRUE);
+	for (i = 0; i < file_count; i++)
+	{
+		gchar *file_name = g_strdup_printf("%s%cfile%u.c", dir_name, G_DIR_SEPARATOR, i);
+
+		g_unlink(file_name);
+		g_free(file_name);
+	}
+	g_rmdir(dir_name);
+	g_free(dir_name);
+	g_string_free(str, TRUE);
+	g_rand_free(rand);
+	g_timer_destroy(timer);
+}
+
+
+/* Loads global C++ tags of a class hierarchy like those of Qt or gtkmm, every class
+ * inheriting from two classes of the level above, and looks up the members of
+ * classes including the inherited ones. Every class overrides the "overridden"
+ * member; returns FALSE if a lookup returns the inherited one instead. */
+static gboolean bench_hierarchy(const gchar *tmp_dir)
+{
+	gchar *tags_file = g_build_filename(tmp_dir, "hierarchy.cpp.tags", NULL);
+	gchar *file_name = g_build_filename(tmp_dir, "hierarchy.cpp", NULL);
+	GString *str = g_string_new("!_TAG_FILE_FORMAT\t2\n");
+	GString *empty = g_string_new(NULL);
+	TMSourceFile *source_file = NULL;
+	GRand *rand = g_rand_new_with_seed(42);
+	GTimer *timer = g_timer_new();
+	guint64 members = 0;
+	guint wrong_overrides = 0;
+	guint d, w, i;
+
+	for (d = 0; d < (guint) hierarchy_depth; d++)
+	{
+		for (w = 0; w < (guint) hierarchy_width; w++)
+		{
+			g_string_append_printf(str, "BenchClass_%u_%u\thierarchy.h\t1;\"\tkind:c", d, w);
+			if (d > 0)
+				g_string_append_printf(str, "\tinherits:BenchClass_%u_%u,BenchClass_%u_%u",
+					d - 1, w, d - 1, (w + 1) % hierarchy_width);
+			g_string_append_c(str, '\n');
+			g_string_append_printf(str,
+				"overridden\thierarchy.h\t1;\"\tkind:m\tclass:BenchClass_%u_%u\n", d, w);
+			for (i = 0; i < 20; i++)
+				g_string_append_printf(str,
+					"member_%u_%u_%u\thierarchy.h\t1;\"\tkind:m\tclass:BenchClass_%u_%u\n",
+					d, w, i, d, w);
+		}
+	}
+
+	if (!write_file(tags_file, str) || !write_file(file_name, empty) ||
+		(source_file = tm_source_file_new(file_name, "C++")) == NULL)
+		goto cleanup;
+
+	g_timer_start(timer);
+	tm_workspace_load_global_tags(tags_file, source_file->lang);
+	report("hierarchy_load", "tags", (guint64) hierarchy_depth * hierarchy_width * 22,
+		g_timer_elapsed(timer, NULL));
+
+	g_timer_start(timer);
+	for (i = 0; i < (guint) queries; i++)
+	{
+		gchar name[64];
+		GPtrArray *tags;
+
+		g_snprintf(name, sizeof name, "BenchClass_%u_%u",
+			g_rand_int_range(rand, 0, MAX(hierarchy_depth, 1)),
+			g_rand_int_range(rand, 0, MAX(hierarchy_width, 1)));
+		tags = tm_workspace_find_scope_members(source_file, name, FALSE, FALSE, "", FALSE);
+		if (tags)
+		{
+			guint j;
+
+			for (j = 0; j < tags->len; j++)
+			{
+				TMTag *tag = tags->pdata[j];
+
+				if (strcmp(tag->name, "overridden") == 0 && g_strcmp0(tag->scope, name) != 0)
+					wrong_overrides++;
+			}
+			members += tags->len;
+			g_ptr_array_free(tags, TRUE);
+		}
+	}
+	report("hierarchy_find_scope_members", "queries", queries, g_timer_elapsed(timer, NULL));
+	report("hierarchy_members_returned", "members", members, g_timer_elapsed(timer, NULL));
+	if (wrong_overrides > 0)
+		g_printerr("%u member lookups returned an inherited member instead of the overriding one\n",
+			wrong_overrides);
+
+cleanup:
+	if (source_file)
+		tm_source_file_free(source_file);
+	g_unlink(tags_file);
+	g_unlink(file_name);
+	g_free(tags_file);
+	g_free(file_name);
+	g_string_free(str, TRUE);
+	g_string_free(empty, TRUE);
+	g_rand_free(rand);
+	g_timer_destroy(timer);
+	return wrong_overrides == 0;
+}
+
+
+/* Global tags of C, C++ and Python with some names common to all of them, and
+ * searches in one language while the others are loaded, too. */
+static void bench_languages(const gchar *tmp_dir)
+{
+	const gchar *lang_names[] = { "C", "C++", "Python" };
+	const gchar *extensions[] = { "c", "cpp", "py" };
+	const gchar *type_kinds[] = { "s", "c", "c" };
+	GRand *rand = g_rand_new_with_seed(42);
+	GTimer *timer = g_timer_new();
+	gchar benchmark[64];
+	guint l, i;
+
+	g_timer_start(timer);
+	for (l = 0; l < G_N_ELEMENTS(lang_names); l++)
+	{
+		gchar *tags_file = g_strdup_printf("%s%clanguages.%s.tags", tmp_dir,
+			G_DIR_SEPARATOR, extensions[l]);
+		GString *str = g_string_new("!_TAG_FILE_FORMAT\t2\n");
+
+		for (i = 0; i < (guint) language_tags; i++)
+		{
+			/* every tenth tag is a type, the names of every fifth are shared */
+			if (i % 5 == 0)
+				g_string_append_printf(str, "bench_shared_%u", i);
+			else
+				g_string_append_printf(str, "bench_%s_%u", extensions[l], i);
+			g_string_append_printf(str, "\tlanguages.%s\t1;\"\tkind:%s\n",
+				extensions[l], i % 10 == 0 ? type_kinds[l] : "f");
+		}
+		if (write_file(tags_file, str))
+			tm_workspace_load_global_tags(tags_file, tm_source_file_get_named_lang(lang_names[l]));
+
+		g_unlink(tags_file);
+		g_free(tags_file);
+		g_string_free(str, TRUE);
+	}
+	report("languages_load", "tags", (guint64) language_tags * G_N_ELEMENTS(lang_names),
+		g_timer_elapsed(timer, NULL));
+
+	for (l = 0; l < G_N_ELEMENTS(lang_names); l++)
+	{
+		TMParserType lang = tm_source_file_get_named_lang(lang_names[l]);
+
+		g_timer_start(timer);
+		for (i = 0; i < (guint) queries; i++)
+		{
+			gchar name[64];
+			GPtrArray *tags;
+
+			g_snprintf(name, sizeof name, "bench_shared_%u",
+				g_rand_int_range(rand, 0, MAX(language_tags / 5, 1)) * 5);
+			tags = tm_workspace_find(name, NULL, tm_tag_max_t, NULL, lang);
+			g_ptr_array_free(tags, TRUE);
+		}
+		g_snprintf(benchmark, sizeof benchmark, "languages_find/%s", lang_names[l]);
+		report(benchmark, "queries", queries, g_timer_elapsed(timer, NULL));
+
+		/* short prefixes match the tags of all languages */
+		g_timer_start(timer);
+		for (i = 0; i < (guint) queries; i++)
+		{
+			gchar prefix[64];
+			GPtrArray *tags;
+
+			g_snprintf(prefix, sizeof prefix, "bench_shared_%u", g_rand_int_range(rand, 0, 10));
+			tags = tm_workspace_find_prefix(i % 2 ? "bench_" : prefix, lang, 100);
+			g_ptr_array_free(tags, TRUE);
+		}
+		g_snprintf(benchmark, sizeof benchmark, "languages_find_prefix/%s", lang_names[l]);
+		report(benchmark, "queries", queries, g_timer_elapsed(timer, NULL));
+
+		/* what highlighting the global type names of the language does */
+		g_timer_start(timer);
+		for (i = 0; i < 100; i++)
+		{
+			GPtrArray *tags = tm_workspace_find_global_typenames(lang);
+
+			g_ptr_array_free(tags, TRUE);
+		}
+		g_snprintf(benchmark, sizeof benchmark, "languages_typenames/%s", lang_names[l]);
+		report(benchmark, "lookups", 100, g_timer_elapsed(timer, NULL));
+	}
+
+	g_rand_free(rand);
+	g_timer_destroy(timer);
+}
+
+
+int main(int argc, char **argv)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	gchar **scale, **scale_list;
+	gchar *tmp_dir;
+	gboolean ok;
+	gint i;
+
+	context = g_option_context_new("[CORPUS_DIR...] - benchmark the tag manager");
+	g_option_context_add_main_entries(context, entries, NULL);
+	if (!g_option_context_parse(context, &argc, &argv, &error))
+	{
+		g_printerr("%s\n", error->message);
+		g_error_free(error);
+		g_option_context_free(context);
+		return 1;
+	}
+	g_option_context_free(context);
+
+	iterations = MAX(iterations, 1);
+	tmp_dir = g_dir_make_tmp("tm_bench-XXXXXX", &error);
+	if (!tmp_dir)
+	{
+		g_printerr("Cannot create a temporary directory: %s\n", error->message);
+		g_error_free(error);
+		return 1;
+	}
+
+	/* creates the workspace and initializes ctags */
+	tm_get_workspace();
+
+	for (i = 1; i < argc; i++)
+		bench_corpus(argv[i]);
+
+	bench_synthetic_parse(tmp_dir);
+	bench_synthetic_header(tmp_dir);
+
+	scale_list = g_strsplit(scales ? scales : "1000,10000,100000", ",", -1);
+	for (scale = scale_list; *scale; scale++)
+	{
+		guint64 file_count = g_ascii_strtoull(*scale, NULL, 10);
+
+		if (file_count > 0)
+			bench_workspace(tmp_dir, (guint) file_count);
+	}
+	g_strfreev(scale_list);
+
+	ok = bench_hierarchy(tmp_dir);
+	bench_languages(tmp_dir);
+
+	g_rmdir(tmp_dir);
+	g_free(tmp_dir);
+	tm_workspace_free();
+	return ok ? 0 : 1;
+}